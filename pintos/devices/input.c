@@ -1,15 +1,28 @@
 #include "devices/input.h"
 #include <debug.h>
+#include <stdio.h>
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/synch.h"
+
+/* Input buffer size, in keys. */
+#define INPUT_BUFSIZE 64
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
+static uint8_t buffer_data[INPUT_BUFSIZE]
+	__attribute__ ((aligned (CACHE_LINE_SIZE)));
+
+/* The keyboard and serial interrupts both run on the boot CPU
+   with interrupts off, so there is only ever one producer.
+   Readers may be any number of threads, so serialize them. */
+static struct lock read_lock;
 
 /* Initializes the input buffer. */
 void
 input_init (void) {
-	intq_init (&buffer);
+	intq_init (&buffer, buffer_data, 1, INPUT_BUFSIZE);
+	lock_init (&read_lock);
 }
 
 /* Adds a key to the input buffer.
@@ -19,7 +32,7 @@ input_putc (uint8_t key) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (!intq_full (&buffer));
 
-	intq_putc (&buffer, key);
+	intq_put (&buffer, &key);
 	serial_notify ();
 }
 
@@ -27,17 +40,36 @@ input_putc (uint8_t key) {
    If the buffer is empty, waits for a key to be pressed. */
 uint8_t
 input_getc (void) {
-	enum intr_level old_level;
 	uint8_t key;
 
-	old_level = intr_disable ();
-	key = intq_getc (&buffer);
-	serial_notify ();
-	intr_set_level (old_level);
-
+	input_read (&key, 1);
 	return key;
 }
 
+/* Reads SIZE keys from the input buffer into BUF, waiting for
+   keys to be pressed as necessary.  Takes every key that is
+   already buffered at once, so a burst of input costs a single
+   wakeup. */
+void
+input_read (void *buf_, size_t size) {
+	uint8_t *buf = buf_;
+
+	lock_acquire (&read_lock);
+	while (size > 0) {
+		enum intr_level old_level;
+		size_t cnt = intq_get (&buffer, buf, size);
+
+		buf += cnt;
+		size -= cnt;
+
+		/* There is room in the buffer again. */
+		old_level = intr_disable ();
+		serial_notify ();
+		intr_set_level (old_level);
+	}
+	lock_release (&read_lock);
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
@@ -46,3 +78,9 @@ input_full (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	return intq_full (&buffer);
 }
+
+/* Prints input buffer statistics. */
+void
+input_print_stats (void) {
+	printf ("Input: %lld wakeups\n", buffer.wakeup_cnt);
+}
@@ -1,105 +1,145 @@
 #include "devices/intq.h"
 #include <debug.h>
+#include <string.h>
+#include "threads/interrupt.h"
 #include "threads/thread.h"
 
-static int next (int pos);
-static void wait (struct intq *q, struct thread **waiter);
-static void signal (struct intq *q, struct thread **waiter);
+static void wait (struct intq *q);
+static void signal (struct intq *q);
 
-/* Initializes interrupt queue Q. */
+/* Initializes interrupt queue Q to hold REC_CNT records of
+   REC_SIZE bytes each in BUF, which must be REC_SIZE * REC_CNT
+   bytes long.  REC_CNT must be a power of two. */
 void
-intq_init (struct intq *q) {
-	lock_init (&q->lock);
-	q->not_full = q->not_empty = NULL;
+intq_init (struct intq *q, void *buf, size_t rec_size, size_t rec_cnt) {
+	ASSERT (buf != NULL);
+	ASSERT (rec_size > 0);
+	ASSERT (rec_cnt > 0 && (rec_cnt & (rec_cnt - 1)) == 0);
+
 	q->head = q->tail = 0;
+	q->buf = buf;
+	q->rec_size = rec_size;
+	q->mask = rec_cnt - 1;
+	spinlock_init (&q->wait_lock, "intq");
+	q->waiter = NULL;
+	q->wakeup_cnt = 0;
 }
 
-/* Returns true if Q is empty, false otherwise. */
+/* Returns true if Q is empty, false otherwise.
+   Only exact when called by the consumer. */
 bool
 intq_empty (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	return q->head == q->tail;
+	return __atomic_load_n (&q->head, __ATOMIC_ACQUIRE) == q->tail;
 }
 
-/* Returns true if Q is full, false otherwise. */
+/* Returns true if Q is full, false otherwise.
+   Only exact when called by the producer. */
 bool
 intq_full (const struct intq *q) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	return next (q->head) == q->tail;
+	return q->head - __atomic_load_n (&q->tail, __ATOMIC_ACQUIRE) > q->mask;
 }
 
-/* Removes a byte from Q and returns it.
-   Q must not be empty if called from an interrupt handler.
-   Otherwise, if Q is empty, first sleeps until a byte is
-   added. */
-uint8_t
-intq_getc (struct intq *q) {
-	uint8_t byte;
-
-	ASSERT (intr_get_level () == INTR_OFF);
-	while (intq_empty (q)) {
-		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
-		wait (q, &q->not_empty);
-		lock_release (&q->lock);
-	}
+/* Adds the record at REC to the end of Q and wakes up the
+   consumer if it is waiting.  Returns false without adding
+   anything if Q is full.
+   May be called from an interrupt handler. */
+bool
+intq_put (struct intq *q, const void *rec) {
+	size_t head = q->head;
+
+	if (intq_full (q))
+		return false;
 
-	byte = q->buf[q->tail];
-	q->tail = next (q->tail);
-	signal (q, &q->not_full);
-	return byte;
+	memcpy (q->buf + (head & q->mask) * q->rec_size, rec, q->rec_size);
+
+	/* Publish the record only after it has been written. */
+	__atomic_store_n (&q->head, head + 1, __ATOMIC_RELEASE);
+	signal (q);
+	return true;
 }
 
-/* Adds BYTE to the end of Q.
-   Q must not be full if called from an interrupt handler.
-   Otherwise, if Q is full, first sleeps until a byte is
-   removed. */
-void
-intq_putc (struct intq *q, uint8_t byte) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	while (intq_full (q)) {
-		ASSERT (!intr_context ());
-		lock_acquire (&q->lock);
-		wait (q, &q->not_full);
-		lock_release (&q->lock);
+/* Removes up to MAX records from the front of Q into RECS and
+   returns how many were removed, which is 0 if Q is empty.
+   May be called from an interrupt handler. */
+size_t
+intq_get_nb (struct intq *q, void *recs, size_t max) {
+	size_t tail = q->tail;
+	size_t cnt = __atomic_load_n (&q->head, __ATOMIC_ACQUIRE) - tail;
+	uint8_t *dst = recs;
+
+	if (cnt > max)
+		cnt = max;
+	for (size_t i = 0; i < cnt; i++) {
+		memcpy (dst, q->buf + ((tail + i) & q->mask) * q->rec_size,
+				q->rec_size);
+		dst += q->rec_size;
 	}
 
-	q->buf[q->head] = byte;
-	q->head = next (q->head);
-	signal (q, &q->not_empty);
+	/* Hand the slots back to the producer only after copying. */
+	__atomic_store_n (&q->tail, tail + cnt, __ATOMIC_RELEASE);
+	return cnt;
 }
 
-/* Returns the position after POS within an intq. */
-static int
-next (int pos) {
-	return (pos + 1) % INTQ_BUFSIZE;
+/* Removes up to MAX records from the front of Q into RECS,
+   first sleeping until at least one record is available.
+   Returns the number of records removed, which is at least 1
+   if MAX is positive.
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+size_t
+intq_get (struct intq *q, void *recs, size_t max) {
+	size_t cnt;
+
+	ASSERT (!intr_context ());
+
+	while ((cnt = intq_get_nb (q, recs, max)) == 0 && max > 0)
+		wait (q);
+	return cnt;
 }
 
-/* WAITER must be the address of Q's not_empty or not_full
-   member.  Waits until the given condition is true. */
+/* Sleeps until Q is not empty. */
 static void
-wait (struct intq *q UNUSED, struct thread **waiter) {
-	ASSERT (!intr_context ());
-	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT ((waiter == &q->not_empty && intq_empty (q))
-			|| (waiter == &q->not_full && intq_full (q)));
+wait (struct intq *q) {
+	enum intr_level old_level;
+
+	old_level = spin_lock_irqsave (&q->wait_lock);
+	ASSERT (q->waiter == NULL);
+	q->waiter = thread_current ();
 
-	*waiter = thread_current ();
-	thread_block ();
+	/* Pairs with the fence in signal(): either the producer sees
+	   WAITER, or we see its new HEAD. */
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+	if (intq_empty (q))
+		thread_block_unlock (&q->wait_lock);
+	else {
+		q->waiter = NULL;
+		spin_unlock (&q->wait_lock);
+	}
+	intr_set_level (old_level);
 }
 
-/* WAITER must be the address of Q's not_empty or not_full
-   member, and the associated condition must be true.  If a
-   thread is waiting for the condition, wakes it up and resets
-   the waiting thread. */
+/* Wakes up Q's consumer, if it is sleeping.  Records that arrive
+   before it runs again find WAITER null and cost no wakeup. */
 static void
-signal (struct intq *q UNUSED, struct thread **waiter) {
-	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT ((waiter == &q->not_empty && !intq_empty (q))
-			|| (waiter == &q->not_full && !intq_full (q)));
-
-	if (*waiter != NULL) {
-		thread_unblock (*waiter);
-		*waiter = NULL;
+signal (struct intq *q) {
+	enum intr_level old_level;
+	struct thread *t;
+	bool preempt;
+
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+	if (__atomic_load_n (&q->waiter, __ATOMIC_RELAXED) == NULL)
+		return;
+
+	old_level = spin_lock_irqsave (&q->wait_lock);
+	t = q->waiter;
+	q->waiter = NULL;
+	if (t != NULL) {
+		thread_unblock (t);
+		q->wakeup_cnt++;
 	}
+	preempt = t != NULL && thread_should_preempt (t);
+	spin_unlock_irqrestore (&q->wait_lock, old_level);
+
+	if (preempt)
+		thread_preempt ();
 }
@@ -0,0 +1,237 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/spinlock.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Local APIC.
+
+   CPU마다 하나씩 있는 인터럽트 컨트롤러로, 모든 CPU에서 같은 물리 주소의
+   MMIO 레지스터로 보이지만 실제로는 각자 자기 것에 접근함.
+   다른 CPU를 깨우거나(INIT/STARTUP IPI) 재스케줄을 요청하는 IPI를
+   보내고, AP에게 주기적인 타이머 인터럽트를 줌.
+   BSP는 여전히 8259A PIC와 8254 PIT로 장치와 타이머 인터럽트를 받음.
+   See [IA32-v3a] chapter 10 "Advanced Programmable Interrupt Controller". */
+
+/* 레지스터 오프셋 (바이트). */
+#define LAPIC_ID        0x020       /* Local APIC ID. */
+#define LAPIC_TPR       0x080       /* Task Priority. */
+#define LAPIC_EOI       0x0b0       /* End Of Interrupt. */
+#define LAPIC_SVR       0x0f0       /* Spurious Interrupt Vector. */
+#define LAPIC_ESR       0x280       /* Error Status. */
+#define LAPIC_ICR_LO    0x300       /* Interrupt Command [31:0]. */
+#define LAPIC_ICR_HI    0x310       /* Interrupt Command [63:32]. */
+#define LAPIC_LVT_TIMER 0x320       /* LVT Timer. */
+#define LAPIC_LVT_LINT0 0x350       /* LVT LINT0. */
+#define LAPIC_LVT_LINT1 0x360       /* LVT LINT1. */
+#define LAPIC_LVT_ERROR 0x370       /* LVT Error. */
+#define LAPIC_TIMER_ICR 0x380       /* 타이머 초기 카운트. */
+#define LAPIC_TIMER_CCR 0x390       /* 타이머 현재 카운트. */
+#define LAPIC_TIMER_DCR 0x3e0       /* 타이머 분주 설정. */
+
+#define SVR_ENABLE      0x00000100  /* 소프트웨어 활성화. */
+#define LVT_MASKED      0x00010000  /* 인터럽트 마스크. */
+#define LVT_PERIODIC    0x00020000  /* 타이머 주기 모드. */
+#define ICR_INIT        0x00000500  /* INIT 전달 모드. */
+#define ICR_STARTUP     0x00000600  /* STARTUP 전달 모드. */
+#define ICR_PENDING     0x00001000  /* 전달 중. */
+#define ICR_ASSERT      0x00004000  /* 레벨 assert. */
+#define ICR_LEVEL       0x00008000  /* 레벨 트리거. */
+#define DCR_DIV_16      0x3         /* 버스 클럭 / 16. */
+
+/* Local APIC 레지스터의 커널 가상 주소. 매핑 전에는 NULL */
+static volatile uint32_t *lapic;
+
+/* 타이머 한 tick(1/TIMER_FREQ 초)에 해당하는 Local APIC 타이머 카운트. */
+static uint32_t lapic_timer_count;
+
+static intr_handler_func lapic_timer_interrupt;
+static intr_handler_func lapic_resched_interrupt;
+
+static uint32_t
+lapic_read (int reg) {
+	return lapic[reg / 4];
+}
+
+static void
+lapic_write (int reg, uint32_t value) {
+	lapic[reg / 4] = value;
+
+	/* 쓰기가 끝날 때까지 기다리기 위해 아무 레지스터나 한 번 읽음 */
+	(void) lapic[LAPIC_ID / 4];
+}
+
+/* 물리 주소 PADDR에 있는 Local APIC 레지스터를 캐시 없이 커널 영역에 */
+/* 매핑하고 인터럽트 핸들러를 등록. BSP에서 한 번만 호출 */
+void
+lapic_map (uint64_t paddr) {
+	uint64_t va = (uint64_t) ptov (paddr);
+	uint64_t *pte;
+
+	ASSERT (0 == pg_ofs (paddr));
+	ASSERT (NULL == lapic);
+
+	/* 물리 메모리 끝보다 위에 있으므로 paging_init()이 매핑해두지 않았음 */
+	pte = pml4e_walk (base_pml4, va, 1);
+	if (NULL == pte)
+	{
+		PANIC ("lapic: cannot map registers at %#"PRIx64, paddr);
+	}
+	*pte = paddr | PTE_P | PTE_W | PTE_PWT | PTE_PCD;
+	invlpg (va);
+
+	lapic = (volatile uint32_t *) va;
+
+	intr_register_ext (LAPIC_TIMER_VEC, lapic_timer_interrupt, "LAPIC Timer");
+	intr_register_ext (LAPIC_RESCHED_VEC, lapic_resched_interrupt,
+			"Reschedule IPI");
+}
+
+/* Local APIC를 매핑했다면 true */
+bool
+lapic_present (void) {
+	return NULL != lapic;
+}
+
+/* 현재 CPU의 Local APIC를 활성화. BSP라면 BSP를 true로 줌. */
+/* 인터럽트가 꺼져 있어야 함 */
+void
+lapic_init (bool bsp) {
+	ASSERT (lapic_present ());
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lapic_write (LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+
+	/* BSP의 LINT0은 BIOS가 8259A PIC의 인터럽트를 받도록(ExtINT) 설정해 두었으므로 */
+	/* 그대로 둠. AP는 장치 인터럽트를 받지 않음 */
+	if (!bsp)
+	{
+		lapic_write (LAPIC_LVT_LINT0, LVT_MASKED);
+		lapic_write (LAPIC_LVT_LINT1, LVT_MASKED);
+	}
+	lapic_write (LAPIC_LVT_TIMER, LVT_MASKED);
+	lapic_write (LAPIC_LVT_ERROR, LVT_MASKED);
+
+	/* 남아있는 오류와 인터럽트를 정리하고 모든 우선순위의 인터럽트를 받음 */
+	lapic_write (LAPIC_ESR, 0);
+	lapic_write (LAPIC_ESR, 0);
+	lapic_write (LAPIC_EOI, 0);
+	lapic_write (LAPIC_TPR, 0);
+}
+
+/* PIT 한 tick 동안 Local APIC 타이머가 세는 양을 잼. */
+/* BSP에서 timer_calibrate() 뒤에 인터럽트를 켠 채로 호출 */
+void
+lapic_calibrate (void) {
+	int64_t start;
+
+	ASSERT (lapic_present ());
+	ASSERT (intr_get_level () == INTR_ON);
+
+	lapic_write (LAPIC_TIMER_DCR, DCR_DIV_16);
+	lapic_write (LAPIC_LVT_TIMER, LVT_MASKED);
+
+	/* tick 경계에서 시작해서 정확히 한 tick 동안 줄어든 카운트를 읽음 */
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+	{
+		cpu_relax ();
+	}
+	lapic_write (LAPIC_TIMER_ICR, UINT32_MAX);
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+	{
+		cpu_relax ();
+	}
+	lapic_timer_count = UINT32_MAX - lapic_read (LAPIC_TIMER_CCR);
+	lapic_write (LAPIC_TIMER_ICR, 0);
+
+	printf ("Local APIC timer: %'"PRIu64" counts/s.\n",
+			(uint64_t) lapic_timer_count * TIMER_FREQ);
+}
+
+/* 현재 CPU의 Local APIC 타이머가 초당 TIMER_FREQ번 인터럽트를 */
+/* 발생시키도록 설정. AP에서 호출 */
+void
+lapic_timer_start (void) {
+	ASSERT (0 < lapic_timer_count);
+
+	lapic_write (LAPIC_TIMER_DCR, DCR_DIV_16);
+	lapic_write (LAPIC_LVT_TIMER, LVT_PERIODIC | LAPIC_TIMER_VEC);
+	lapic_write (LAPIC_TIMER_ICR, lapic_timer_count);
+}
+
+/* 현재 CPU의 Local APIC ID 반환 */
+uint8_t
+lapic_id (void) {
+	return lapic_read (LAPIC_ID) >> 24;
+}
+
+/* 처리를 마친 Local APIC 인터럽트를 알림 */
+void
+lapic_eoi (void) {
+	lapic_write (LAPIC_EOI, 0);
+}
+
+/* APIC_ID에게 ICR 명령 LO를 보내고 전달될 때까지 기다림 */
+static void
+lapic_icr (uint8_t apic_id, uint32_t lo) {
+	enum intr_level old_level = intr_disable ();
+
+	/* 두 레지스터를 쓰는 사이에 같은 CPU의 인터럽트 핸들러가 끼어들면 안 됨 */
+	lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+	lapic_write (LAPIC_ICR_LO, lo);
+	while (0 != (lapic_read (LAPIC_ICR_LO) & ICR_PENDING))
+	{
+		cpu_relax ();
+	}
+
+	intr_set_level (old_level);
+}
+
+/* APIC_ID인 CPU에게 INIT IPI를 보내 리셋 상태로 만듦 */
+void
+lapic_send_init (uint8_t apic_id) {
+	lapic_icr (apic_id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+	lapic_icr (apic_id, ICR_INIT | ICR_LEVEL);
+}
+
+/* INIT 상태인 APIC_ID CPU가 물리 주소 PADDR의 리얼 모드 코드부터 */
+/* 실행하도록 STARTUP IPI를 보냄. PADDR은 1MB 아래의 페이지 경계여야 함 */
+void
+lapic_send_startup (uint8_t apic_id, uint64_t paddr) {
+	ASSERT (0 == pg_ofs (paddr) && paddr < 0x100000);
+
+	lapic_icr (apic_id, ICR_STARTUP | (paddr >> PGBITS));
+}
+
+/* APIC_ID인 CPU에게 인터럽트 벡터 VEC를 보냄 */
+void
+lapic_send_ipi (uint8_t apic_id, uint8_t vec) {
+	ASSERT (LAPIC_VEC_MIN <= vec);
+
+	lapic_icr (apic_id, vec);
+}
+
+/* AP의 타이머 인터럽트 핸들러. */
+/* 전역 tick은 BSP의 PIT가 세므로 여기서는 스케줄링만 함 */
+static void
+lapic_timer_interrupt (struct intr_frame *args UNUSED) {
+	thread_tick ();
+}
+
+/* 다른 CPU가 이 CPU의 준비 큐에 더 급한 스레드를 넣었음 */
+static void
+lapic_resched_interrupt (struct intr_frame *args UNUSED) {
+	this_cpu ()->ipi_cnt++;
+	intr_yield_on_return ();
+}
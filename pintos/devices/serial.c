@@ -5,6 +5,7 @@
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 
@@ -51,11 +52,22 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
+/* Transmit queue size, in bytes. */
+#define TXQ_BUFSIZE 64
+
 /* Data to be transmitted. */
 static struct intq txq;
+static uint8_t txq_data[TXQ_BUFSIZE]
+	__attribute__ ((aligned (CACHE_LINE_SIZE)));
+
+/* txq와 IER 레지스터를 보호. 출력은 어느 CPU에서든 하지만 */
+/* 큐를 비우는 인터럽트는 BSP만 받음. 0으로 초기화된 상태로 바로 쓸 수 있음. */
+/* txq의 생산자와 소비자가 모두 이 락 아래에서만 큐를 만지므로 한 쪽에 하나씩임 */
+static struct spinlock tx_lock;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
+static uint8_t txq_getc (void);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
 
@@ -70,7 +82,7 @@ init_poll (void) {
 	outb (FCR_REG, 0);                    /* Disable FIFO. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	intq_init (&txq, txq_data, 1, TXQ_BUFSIZE);
 	mode = POLL;
 }
 
@@ -86,16 +98,16 @@ serial_init_queue (void) {
 	ASSERT (mode == POLL);
 
 	intr_register_ext (0x20 + 4, serial_interrupt, "serial");
+	old_level = spin_lock_irqsave (&tx_lock);
 	mode = QUEUE;
-	old_level = intr_disable ();
 	write_ier ();
-	intr_set_level (old_level);
+	spin_unlock_irqrestore (&tx_lock, old_level);
 }
 
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) {
-	enum intr_level old_level = intr_disable ();
+	enum intr_level old_level = spin_lock_irqsave (&tx_lock);
 
 	if (mode != QUEUE) {
 		/* If we're not set up for interrupt-driven I/O yet,
@@ -106,30 +118,29 @@ serial_putc (uint8_t byte) {
 	} else {
 		/* Otherwise, queue a byte and update the interrupt enable
 		   register. */
-		if (old_level == INTR_OFF && intq_full (&txq)) {
-			/* Interrupts are off and the transmit queue is full.
-			   If we wanted to wait for the queue to empty,
-			   we'd have to reenable interrupts.
-			   That's impolite, so we'll send a character via
-			   polling instead. */
-			putc_poll (intq_getc (&txq));
+		if (intq_full (&txq)) {
+			/* The transmit queue is full.  The interrupt that
+			   drains it may be delivered to another CPU, and
+			   we hold tx_lock, so we can't sleep waiting for it.
+			   Send a character via polling instead. */
+			putc_poll (txq_getc ());
 		}
 
-		intq_putc (&txq, byte);
+		intq_put (&txq, &byte);
 		write_ier ();
 	}
 
-	intr_set_level (old_level);
+	spin_unlock_irqrestore (&tx_lock, old_level);
 }
 
 /* Flushes anything in the serial buffer out the port in polling
    mode. */
 void
 serial_flush (void) {
-	enum intr_level old_level = intr_disable ();
+	enum intr_level old_level = spin_lock_irqsave (&tx_lock);
 	while (!intq_empty (&txq))
-		putc_poll (intq_getc (&txq));
-	intr_set_level (old_level);
+		putc_poll (txq_getc ());
+	spin_unlock_irqrestore (&tx_lock, old_level);
 }
 
 /* The fullness of the input buffer may have changed.  Reassess
@@ -139,8 +150,10 @@ serial_flush (void) {
 void
 serial_notify (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
+	spin_lock (&tx_lock);
 	if (mode == QUEUE)
 		write_ier ();
+	spin_unlock (&tx_lock);
 }
 
 /* Configures the serial port for BPS bits per second. */
@@ -167,7 +180,7 @@ static void
 write_ier (void) {
 	uint8_t ier = 0;
 
-	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held (&tx_lock));
 
 	/* Enable transmit interrupt if we have any characters to
 	   transmit. */
@@ -193,6 +206,18 @@ putc_poll (uint8_t byte) {
 	outb (THR_REG, byte);
 }
 
+/* Removes and returns the oldest byte in the transmit queue,
+   which must not be empty. */
+static uint8_t
+txq_getc (void) {
+	uint8_t byte;
+
+	ASSERT (spin_held (&tx_lock));
+	if (intq_get_nb (&txq, &byte, 1) == 0)
+		NOT_REACHED ();
+	return byte;
+}
+
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) {
@@ -207,9 +232,11 @@ serial_interrupt (struct intr_frame *f UNUSED) {
 
 	/* As long as we have a byte to transmit, and the hardware is
 	   ready to accept a byte for transmission, transmit a byte. */
+	spin_lock (&tx_lock);
 	while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
-		outb (THR_REG, intq_getc (&txq));
+		outb (THR_REG, txq_getc ());
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier ();
+	spin_unlock (&tx_lock);
 }
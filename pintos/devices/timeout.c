@@ -0,0 +1,247 @@
+#include "devices/timeout.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/spinlock.h"
+
+/* 계층형 타이머 휠.
+
+   레벨 L의 슬롯 하나는 64^L tick 구간을 담당함. 만료까지 남은 tick 수에
+   따라 레벨을 고르고, 만료 tick의 해당 비트로 슬롯을 고르므로 등록은 O(1).
+   각 tick마다 레벨 0의 슬롯 하나만 실행하고, 레벨 0이 한 바퀴 돌 때마다
+   윗 레벨의 슬롯 하나를 아래 레벨로 내려보냄(cascade).
+
+   4개 레벨 x 64 슬롯으로 2^24 tick(100Hz 기준 약 46시간)까지 표현하며,
+   그보다 먼 타임아웃은 최상위 레벨의 마지막 슬롯에 두었다가 내려올 때
+   다시 배치함. */
+
+#define WHEEL_BITS 6                            /* 레벨당 슬롯 비트 수. */
+#define WHEEL_SIZE (1 << WHEEL_BITS)            /* 레벨당 슬롯 수. */
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4                          /* 레벨 수. */
+#define WHEEL_SPAN (1LL << (WHEEL_BITS * WHEEL_LEVELS))  /* 표현 가능한 최대 거리. */
+
+/* 레벨별 슬롯 리스트. */
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+
+/* 타이머 휠이 마지막으로 처리한 tick. */
+static int64_t wheel_now;
+
+/* 타이머 휠과 struct timeout의 elem, pending을 보호. */
+/* 콜백은 이 락을 놓은 채로 실행하므로 콜백 안에서 등록/취소할 수 있음 */
+static struct spinlock wheel_lock;
+
+/* 지금 콜백을 실행 중인 타임아웃. timeout_cancel()이 기다리는 데 씀 */
+static struct timeout *volatile wheel_running;
+
+/* 통계. */
+static long long armed_cnt;     /* 등록된 타임아웃 수. */
+static long long fired_cnt;     /* 만료되어 실행된 타임아웃 수. */
+static long long cascade_cnt;   /* 아래 레벨로 재배치된 횟수. */
+
+static void wheel_place (struct timeout *);
+static void wheel_cascade (int level);
+
+/* 타이머 휠 초기화. timer_init()에서 호출 */
+void
+timeout_wheel_init (void) {
+	for (int level = 0; level < WHEEL_LEVELS; ++level)
+	{
+		for (int i = 0; i < WHEEL_SIZE; ++i)
+		{
+			list_init (&wheel[level][i]);
+		}
+	}
+
+	wheel_now = 0;
+	spinlock_init (&wheel_lock, "timeout");
+}
+
+/* 타이머 인터럽트 핸들러에서 매 tick마다 호출. */
+/* NOW까지의 tick을 처리하며 만료된 타임아웃의 콜백을 실행 */
+void
+timeout_wheel_tick (int64_t now) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&wheel_lock);
+	while (wheel_now < now)
+	{
+		struct list *slot;
+
+		wheel_now++;
+
+		/* 레벨 0이 한 바퀴 돌았다면 윗 레벨 슬롯을 아래로 내려보냄. */
+		/* 윗 레벨도 한 바퀴 돌았다면 그 위 레벨까지 연쇄적으로 처리 */
+		for (int level = 1; level < WHEEL_LEVELS; ++level)
+		{
+			if (0 != ((wheel_now >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK))
+			{
+				break;
+			}
+
+			wheel_cascade (level);
+		}
+
+		/* 이번 tick에 만료되는 슬롯 실행. */
+		/* 콜백 안에서 다른 타임아웃을 등록/취소할 수 있으므로 하나씩 꺼냄 */
+		slot = &wheel[0][wheel_now & WHEEL_MASK];
+		while (!list_empty (slot))
+		{
+			struct timeout *t = list_entry (list_pop_front (slot),
+					struct timeout, elem);
+
+			timeout_func *func = t->func;
+			void *aux = t->aux;
+
+			t->pending = false;
+			fired_cnt++;
+			wheel_running = t;
+			spin_unlock (&wheel_lock);
+
+			func (aux);
+
+			spin_lock (&wheel_lock);
+			wheel_running = NULL;
+		}
+	}
+	spin_unlock (&wheel_lock);
+}
+
+/* 타이머 휠 통계 출력 */
+void
+timeout_print_stats (void) {
+	printf ("Timeout: %lld armed, %lld fired, %lld cascaded\n",
+			armed_cnt, fired_cnt, cascade_cnt);
+}
+
+/* 타임아웃 T를 FUNC(AUX)를 호출하도록 초기화. 아직 등록되지는 않음 */
+void
+timeout_init (struct timeout *t, timeout_func *func, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (func != NULL);
+
+	t->func = func;
+	t->aux = aux;
+	t->expires = 0;
+	t->pending = false;
+}
+
+/* 타임아웃 T를 지금으로부터 TICKS tick 뒤에 만료되도록 등록. */
+/* 이미 등록되어 있다면 새로운 만료 시각으로 옮김. */
+/* TICKS가 0 이하라면 다음 tick에 만료됨. 인터럽트 핸들러에서도 호출 가능 */
+void
+timeout_arm (struct timeout *t, int64_t ticks) {
+	enum intr_level old_level;
+
+	ASSERT (t != NULL);
+
+	old_level = spin_lock_irqsave (&wheel_lock);
+
+	if (t->pending)
+	{
+		list_remove (&t->elem);
+	}
+
+	t->expires = wheel_now + (0 < ticks ? ticks : 1);
+	t->pending = true;
+	wheel_place (t);
+	armed_cnt++;
+
+	spin_unlock_irqrestore (&wheel_lock, old_level);
+}
+
+/* 등록된 타임아웃 T를 취소. */
+/* 취소되기 전까지 대기 중이었다면 true, 이미 만료되었거나 등록되지 않았다면 false. */
+/* 다른 CPU에서 T의 콜백이 실행 중이라면 끝날 때까지 기다리므로, 반환 뒤에는 */
+/* T를 해제해도 안전함. 콜백 안에서 자기 자신을 취소하면 안 됨 */
+bool
+timeout_cancel (struct timeout *t) {
+	enum intr_level old_level;
+	bool was_pending;
+
+	ASSERT (t != NULL);
+
+	old_level = spin_lock_irqsave (&wheel_lock);
+
+	was_pending = t->pending;
+	if (was_pending)
+	{
+		list_remove (&t->elem);
+		t->pending = false;
+	}
+
+	while (wheel_running == t)
+	{
+		spin_unlock (&wheel_lock);
+		cpu_relax ();
+		spin_lock (&wheel_lock);
+	}
+
+	spin_unlock_irqrestore (&wheel_lock, old_level);
+
+	return was_pending;
+}
+
+/* 타임아웃 T가 아직 만료되지 않고 대기 중인지 반환 */
+bool
+timeout_pending (const struct timeout *t) {
+	return t->pending;
+}
+
+/* 타임아웃 T를 만료 시각에 맞는 레벨과 슬롯에 넣음. wheel_lock을 잡고 있어야 함 */
+static void
+wheel_place (struct timeout *t) {
+	int64_t expires = t->expires;
+	int64_t delta;
+	int level;
+
+	/* 이미 지난 타임아웃(cascade 도중에만 발생)은 현재 tick 슬롯에 넣어 바로 실행 */
+	if (expires < wheel_now)
+	{
+		expires = wheel_now;
+	}
+
+	/* 표현 범위를 넘어서는 타임아웃은 최상위 레벨의 가장 먼 슬롯에 둠 */
+	delta = expires - wheel_now;
+	if (WHEEL_SPAN <= delta)
+	{
+		expires = wheel_now + WHEEL_SPAN - 1;
+		delta = WHEEL_SPAN - 1;
+	}
+
+	/* 남은 tick 수가 64^(L+1)보다 작은 가장 낮은 레벨 L 선택 */
+	for (level = 0; level < WHEEL_LEVELS - 1; ++level)
+	{
+		if (delta < (1LL << (WHEEL_BITS * (level + 1))))
+		{
+			break;
+		}
+	}
+
+	list_push_back (&wheel[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK],
+			&t->elem);
+}
+
+/* 레벨 LEVEL에서 현재 시각에 해당하는 슬롯의 타임아웃을 모두 꺼내 */
+/* 다시 배치함. 남은 시간이 줄었으므로 모두 아래 레벨로 내려감 */
+static void
+wheel_cascade (int level) {
+	struct list *slot = &wheel[level][(wheel_now >> (WHEEL_BITS * level)) & WHEEL_MASK];
+	struct list pending;
+
+	/* 재배치 도중 같은 슬롯으로 다시 들어가는 경우를 막기 위해 먼저 옮겨둠 */
+	list_init (&pending);
+	while (!list_empty (slot))
+	{
+		list_push_back (&pending, list_pop_front (slot));
+	}
+
+	while (!list_empty (&pending))
+	{
+		struct timeout *t = list_entry (list_pop_front (&pending),
+				struct timeout, elem);
+
+		wheel_place (t);
+		cascade_cnt++;
+	}
+}
@@ -3,23 +3,43 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "devices/timeout.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
-#if TIMER_FREQ < 19
-#error 8254 timer requires TIMER_FREQ >= 19
-#endif
-#if TIMER_FREQ > 1000
-#error TIMER_FREQ <= 1000 recommended
-#endif
+/* Number of timer interrupts per second. */
+int timer_freq = TIMER_FREQ_DEFAULT;
 
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* timer_ns()가 TSC를 나노초로 바꾸는 데 쓰는 값. timer_calibrate()가 설정. */
+/* ns = ns_base + ((TSC - tsc_base) * tsc_mult) >> 32 */
+static uint64_t tsc_base;
+static uint64_t tsc_mult;
+static int64_t ns_base;
+
+/* timer_sleep()으로 잠든 스레드들. 깨어날 tick이 가장 이른 스레드가 top. */
+/* 잠든 스레드는 준비 큐에 들어가지 않으므로 깨어날 때까지 CPU를 전혀 쓰지 않음. */
+static struct heap sleep_queue;
+
+/* sleep_queue를 보호. 잠드는 스레드와 BSP의 타이머 인터럽트가 */
+/* 서로 다른 CPU에서 동시에 접근할 수 있음 */
+static struct spinlock sleep_lock;
+
+/* 깨어날 시간이 된 스레드를 수면 큐에서 꺼내는 하반부 작업. */
+/* 한 tick에 깨어나는 스레드 수에 비례하는 일을 인터럽트를 켠 채로 하도록 미룸 */
+static struct intr_work wakeup_work;
+
+/* 잠든 스레드가 깨어날 때까지 매 tick마다 thread_yield()로 깨어나 */
+/* 시간을 확인했다면 발생했을 스케줄링 횟수. 수면 큐 덕분에 생략된 깨어남 수. */
+static long long avoided_wakeups;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -28,6 +48,9 @@ static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void calibrate_tsc (void);
+static heap_less_func wakeup_less;
+static intr_work_func wakeup_sleepers;
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -36,12 +59,22 @@ void
 timer_init (void) {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	uint16_t count;
+
+	if (TIMER_FREQ < TIMER_FREQ_MIN || TIMER_FREQ > TIMER_FREQ_MAX)
+		PANIC ("timer frequency %d Hz out of range (%d...%d)",
+				TIMER_FREQ, TIMER_FREQ_MIN, TIMER_FREQ_MAX);
+	count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
 
 	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb (0x40, count & 0xff);
 	outb (0x40, count >> 8);
 
+	heap_init (&sleep_queue, wakeup_less, NULL);
+	spinlock_init (&sleep_lock, "sleep");
+	intr_work_init (&wakeup_work, wakeup_sleepers, NULL);
+	timeout_wheel_init ();
+
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -68,6 +101,38 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	calibrate_tsc ();
+}
+
+/* PIT tick을 기준으로 TSC의 주파수를 재서 timer_ns()가 tick보다 */
+/* 촘촘한 시각을 돌려주도록 함. 정확도를 위해 약 50ms 동안 잼 */
+static void
+calibrate_tsc (void) {
+	int64_t span = DIV_ROUND_UP (TIMER_FREQ, 20);
+	int64_t start, end;
+	uint64_t tsc_start, tsc_end, tsc_hz;
+
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+		continue;
+	start = timer_ticks ();
+	tsc_start = rdtsc ();
+	while (timer_ticks () < start + span)
+		continue;
+	end = timer_ticks ();
+	tsc_end = rdtsc ();
+
+	tsc_hz = (tsc_end - tsc_start) * TIMER_FREQ / (end - start);
+	if (tsc_hz == 0)
+		return;
+
+	/* 보정 전후로 시각이 거꾸로 가지 않도록 지금까지의 tick에 이어 붙임 */
+	ns_base = end * (NSEC_PER_SEC / TIMER_FREQ);
+	tsc_base = tsc_end;
+	__atomic_store_n (&tsc_mult, ((uint64_t) NSEC_PER_SEC << 32) / tsc_hz,
+			__ATOMIC_RELEASE);
+	printf ("TSC: %'"PRIu64" Hz.\n", tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -87,14 +152,42 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then;
 }
 
+/* 부팅 후 지난 시간을 나노초 단위로 반환. TSC로 재므로 tick보다 */
+/* 훨씬 촘촘하며 인터럽트가 꺼져 있어도 흐름. timer_calibrate() 전에는 */
+/* tick 단위로만 움직임 */
+int64_t
+timer_ns (void) {
+	uint64_t mult = __atomic_load_n (&tsc_mult, __ATOMIC_ACQUIRE);
+
+	if (mult == 0)
+		return timer_ticks () * (NSEC_PER_SEC / TIMER_FREQ);
+
+	return ns_base + (int64_t) (((unsigned __int128) (rdtsc () - tsc_base)
+			* mult) >> 32);
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
+/* 깨어날 tick을 기록하고 수면 큐에 넣은 뒤 스레드를 block. */
+/* timer_interrupt()가 해당 tick에 도달하면 하반부에서 깨워줌. */
 void
 timer_sleep (int64_t ticks) {
 	int64_t start = timer_ticks ();
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (intr_get_level () == INTR_ON);
-	while (timer_elapsed (start) < ticks)
-		thread_yield ();
+
+	/* 0 이하의 tick은 잠들 필요 없이 바로 반환 */
+	if (0 >= ticks)
+	{
+		return;
+	}
+
+	old_level = spin_lock_irqsave (&sleep_lock);
+	cur->wakeup_tick = start + ticks;
+	heap_push (&sleep_queue, &cur->sleep_elem);
+	thread_block_unlock (&sleep_lock);
+	intr_set_level (old_level);
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -118,16 +211,90 @@ timer_nsleep (int64_t ns) {
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
-	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	printf ("Timer: %"PRId64" ticks, %lld wakeups avoided\n",
+			timer_ticks (), avoided_wakeups);
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	bool due;
+
 	ticks++;
+
+	/* 깨어날 스레드가 있는지만 top으로 확인하고, 깨우는 일은 하반부에 맡김 */
+	spin_lock (&sleep_lock);
+	due = !heap_empty (&sleep_queue)
+		&& heap_entry (heap_top (&sleep_queue), struct thread,
+				sleep_elem)->wakeup_tick <= ticks;
+	if (!due)
+	{
+		/* 잠든 스레드들은 이번 tick에 깨어날 필요가 없었음 */
+		avoided_wakeups += heap_size (&sleep_queue);
+	}
+	spin_unlock (&sleep_lock);
+
+	if (due)
+	{
+		intr_defer (&wakeup_work);
+	}
+
+	/* 만료된 타임아웃 콜백 실행 */
+	timeout_wheel_tick (ticks);
+
 	thread_tick ();
 }
 
+/* 깨어날 시간이 된 스레드만 수면 큐에서 꺼내 깨움. */
+/* top부터 확인하므로 깨어나는 스레드 수에 비례하는 비용만 듦. */
+/* 보통은 작업 스레드에서 실행되지만 부팅 초기에는 타이머 인터럽트 안에서 실행됨 */
+static void
+wakeup_sleepers (void *aux UNUSED) {
+	int64_t now = timer_ticks ();
+	enum intr_level old_level;
+	bool preempt = false;
+
+	old_level = spin_lock_irqsave (&sleep_lock);
+	while (!heap_empty (&sleep_queue))
+	{
+		struct thread *t = heap_entry (heap_top (&sleep_queue),
+				struct thread, sleep_elem);
+
+		if (t->wakeup_tick > now)
+		{
+			break;
+		}
+
+		heap_pop (&sleep_queue);
+		thread_unblock (t);
+
+		/* 현재 스레드보다 우선순위가 높은 스레드가 이 CPU에서 깨어났다면 양보 */
+		if (thread_should_preempt (t))
+		{
+			preempt = true;
+		}
+	}
+
+	/* 아직 잠들어 있는 스레드들은 이번 tick에 깨어날 필요가 없었음 */
+	avoided_wakeups += heap_size (&sleep_queue);
+	spin_unlock_irqrestore (&sleep_lock, old_level);
+
+	if (preempt)
+	{
+		thread_preempt ();
+	}
+}
+
+/* 수면 큐 정렬 함수. 깨어날 tick이 더 이른 스레드가 앞 */
+static bool
+wakeup_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, sleep_elem);
+	const struct thread *b = heap_entry (b_, struct thread, sleep_elem);
+
+	return a->wakeup_tick < b->wakeup_tick;
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
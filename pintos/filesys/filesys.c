@@ -20,6 +20,7 @@ struct disk *filesys_disk;
 /* 파일 시스템 전체를 보호하는 전역 락으로 한 번에 단 하나의 프로세스만이 */
 /* 파일 시스템 관련 작업을 수행할 수 있도록 보장해 경쟁 상태 원천 방지 가능 */
 struct lock filesys_lock;
+static struct lock_stat filesys_lock_stat;
 
 static void do_format (void);
 
@@ -32,9 +33,13 @@ filesys_init (bool format) {
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
 	inode_init ();
+	file_init ();
+	dir_init ();
 
 	/* 전역 락 초기화 */
 	lock_init(&filesys_lock);
+	lock_stat_init (&filesys_lock_stat, "filesys");
+	lock_profile (&filesys_lock, &filesys_lock_stat);
 	
 #ifdef EFILESYS
 	fat_init ();
@@ -6,6 +6,8 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -53,10 +55,24 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* open_inodes를 보호. 대부분은 이미 열린 inode를 찾기만 하므로 */
+/* 읽기로 잡고, 목록에 넣고 뺄 때만 쓰기로 잡음 */
+static struct rwlock open_inodes_lock;
+
+/* 메모리 inode의 슬랩 캐시. 디스크 inode를 품고 있어 malloc()으로는 */
+/* 1 kB 블록을 쓰게 되므로 정확한 크기로 나눠 씀 */
+static struct kmem_cache *inode_cache;
+
+static struct inode *inode_find (disk_sector_t sector);
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	rwlock_init (&open_inodes_lock);
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), 0, NULL);
+	if (inode_cache == NULL)
+		PANIC ("cannot create inode cache");
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,24 +117,29 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode *inode, *open;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	rwlock_acquire_read (&open_inodes_lock);
+	inode = inode_find (sector);
+	rwlock_release_read (&open_inodes_lock);
+	if (inode != NULL)
+		return inode;
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = kmem_cache_alloc (inode_cache);
 	if (inode == NULL)
 		return NULL;
 
+	/* 목록을 놓은 사이에 다른 스레드가 먼저 열었을 수 있음 */
+	rwlock_acquire_write (&open_inodes_lock);
+	open = inode_find (sector);
+	if (open != NULL) {
+		rwlock_release_write (&open_inodes_lock);
+		kmem_cache_free (inode_cache, inode);
+		return open;
+	}
+
 	/* Initialize. */
 	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
@@ -126,14 +147,31 @@ inode_open (disk_sector_t sector) {
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
 	disk_read (filesys_disk, inode->sector, &inode->data);
+	rwlock_release_write (&open_inodes_lock);
 	return inode;
 }
 
+/* SECTOR의 inode가 이미 열려 있다면 다시 열어서 반환. 없다면 NULL. */
+/* open_inodes_lock을 읽기나 쓰기로 잡고 있어야 함 */
+static struct inode *
+inode_find (disk_sector_t sector) {
+	struct list_elem *e;
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector)
+			return inode_reopen (inode);
+	}
+	return NULL;
+}
+
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
+	/* 읽기 락만 잡은 여러 스레드가 동시에 늘릴 수 있음 */
 	if (inode != NULL)
-		inode->open_cnt++;
+		__atomic_add_fetch (&inode->open_cnt, 1, __ATOMIC_RELAXED);
 	return inode;
 }
 
@@ -153,19 +191,24 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
-		/* Deallocate blocks if removed. */
-		if (inode->removed) {
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
-		}
+	rwlock_acquire_write (&open_inodes_lock);
+	if (__atomic_sub_fetch (&inode->open_cnt, 1, __ATOMIC_RELAXED) > 0) {
+		rwlock_release_write (&open_inodes_lock);
+		return;
+	}
 
-		free (inode); 
+	/* Remove from inode list and release lock. */
+	list_remove (&inode->elem);
+	rwlock_release_write (&open_inodes_lock);
+
+	/* Deallocate blocks if removed. */
+	if (inode->removed) {
+		free_map_release (inode->sector, 1);
+		free_map_release (inode->data.start,
+				bytes_to_sectors (inode->data.length)); 
 	}
+
+	kmem_cache_free (inode_cache, inode);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -1,42 +1,55 @@
 #ifndef DEVICES_INTQ_H
 #define DEVICES_INTQ_H
 
-#include "threads/interrupt.h"
-#include "threads/synch.h"
-
-/* An "interrupt queue", a circular buffer shared between
-   kernel threads and external interrupt handlers.
-
-   Interrupt queue functions can be called from kernel threads or
-   from external interrupt handlers.  Except for intq_init(),
-   interrupts must be off in either case.
-
-   The interrupt queue has the structure of a "monitor".  Locks
-   and condition variables from threads/synch.h cannot be used in
-   this case, as they normally would, because they can only
-   protect kernel threads from one another, not from interrupt
-   handlers. */
-
-/* Queue buffer size, in bytes. */
-#define INTQ_BUFSIZE 64
-
-/* A circular queue of bytes. */
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/cpu.h"
+#include "threads/spinlock.h"
+
+/* An "interrupt queue", a ring buffer that hands fixed-size
+   records from one producer to one consumer, typically from an
+   external interrupt handler to a kernel thread.
+
+   The producer only writes HEAD and the consumer only writes
+   TAIL, so neither side needs a lock or has to turn interrupts
+   off to move records; each index lives on its own cache line so
+   that the two sides do not fight over it.  If several threads
+   may produce or consume, the caller must serialize them on that
+   side, e.g. with a lock.
+
+   A consumer thread may sleep until records arrive with
+   intq_get(), which then drains as many records as are ready,
+   up to a caller-given batch size, so that a burst of input
+   costs one wakeup instead of one per record.  Producers never
+   sleep: intq_put() fails if the queue is full. */
+
+/* A ring of fixed-size records. */
 struct intq {
-	/* Waiting threads. */
-	struct lock lock;           /* Only one thread may wait at once. */
-	struct thread *not_full;    /* Thread waiting for not-full condition. */
-	struct thread *not_empty;   /* Thread waiting for not-empty condition. */
-
-	/* Queue. */
-	uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
-	int head;                   /* New data is written here. */
-	int tail;                   /* Old data is read here. */
+	/* Written by the producer only. */
+	size_t head __attribute__ ((aligned (CACHE_LINE_SIZE)));
+	                            /* Records ever added. */
+
+	/* Written by the consumer only. */
+	size_t tail __attribute__ ((aligned (CACHE_LINE_SIZE)));
+	                            /* Records ever removed. */
+
+	/* Set up by intq_init(), then read-only. */
+	uint8_t *buf __attribute__ ((aligned (CACHE_LINE_SIZE)));
+	                            /* REC_CNT records of REC_SIZE bytes. */
+	size_t rec_size;            /* Size of one record, in bytes. */
+	size_t mask;                /* REC_CNT - 1. */
+
+	/* Sleeping consumer. */
+	struct spinlock wait_lock;  /* Protects WAITER. */
+	struct thread *waiter;      /* Consumer waiting for a record. */
+	long long wakeup_cnt;       /* Times the consumer was woken. */
 };
 
-void intq_init (struct intq *);
+void intq_init (struct intq *, void *buf, size_t rec_size, size_t rec_cnt);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
-uint8_t intq_getc (struct intq *);
-void intq_putc (struct intq *, uint8_t);
+bool intq_put (struct intq *, const void *rec);
+size_t intq_get_nb (struct intq *, void *recs, size_t max);
+size_t intq_get (struct intq *, void *recs, size_t max);
 
 #endif /* devices/intq.h */
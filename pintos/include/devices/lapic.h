@@ -0,0 +1,26 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Local APIC가 전달하는 인터럽트 벡터.
+   8259A PIC가 쓰는 0x20...0x2f와 겹치지 않도록 맨 위 구간을 사용함. */
+#define LAPIC_VEC_MIN      0xf0
+#define LAPIC_TIMER_VEC    0xf0     /* AP의 Local APIC 타이머. */
+#define LAPIC_RESCHED_VEC  0xf1     /* 다른 CPU가 보낸 재스케줄 IPI. */
+#define LAPIC_SPURIOUS_VEC 0xff     /* 가짜(spurious) 인터럽트. EOI 불필요. */
+
+void lapic_map (uint64_t paddr);
+bool lapic_present (void);
+void lapic_init (bool bsp);
+void lapic_calibrate (void);
+void lapic_timer_start (void);
+uint8_t lapic_id (void);
+void lapic_eoi (void);
+
+void lapic_send_init (uint8_t apic_id);
+void lapic_send_startup (uint8_t apic_id, uint64_t paddr);
+void lapic_send_ipi (uint8_t apic_id, uint8_t vec);
+
+#endif /* devices/lapic.h */
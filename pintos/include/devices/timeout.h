@@ -0,0 +1,40 @@
+#ifndef DEVICES_TIMEOUT_H
+#define DEVICES_TIMEOUT_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 타이머 인터럽트에서 실행되는 지연 콜백(타임아웃).
+
+   계층형 타이머 휠에 등록되며, 등록(arm)과 취소(cancel)는 모두 O(1).
+   콜백은 만료된 tick의 타이머 인터럽트 안에서, 인터럽트가 꺼진 채로
+   실행되므로 잠들 수 없음. (sema_up(), thread_unblock() 등은 가능)
+
+   struct timeout은 호출자가 소유하며, 대기 중인 동안에는 해제하면
+   안 됨. 스택에 둔 경우 반환 전에 반드시 timeout_cancel()을 호출해야 함.
+   타이머 휠은 BSP의 타이머 인터럽트에서만 돌지만, 등록과 취소는 어느
+   CPU에서든 할 수 있음. */
+
+/* 만료 시 호출되는 콜백. */
+typedef void timeout_func (void *aux);
+
+/* 하나의 타임아웃. */
+struct timeout {
+	struct list_elem elem;      /* 타이머 휠 슬롯 리스트 원소. */
+	int64_t expires;            /* 만료되는 tick. */
+	timeout_func *func;         /* 만료 시 호출할 함수. */
+	void *aux;                  /* FUNC에 넘겨줄 인자. */
+	bool pending;               /* 타이머 휠에 등록되어 있는지 여부. */
+};
+
+void timeout_wheel_init (void);
+void timeout_wheel_tick (int64_t now);
+void timeout_print_stats (void);
+
+void timeout_init (struct timeout *, timeout_func *, void *aux);
+void timeout_arm (struct timeout *, int64_t ticks);
+bool timeout_cancel (struct timeout *);
+bool timeout_pending (const struct timeout *);
+
+#endif /* devices/timeout.h */
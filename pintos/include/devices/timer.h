@@ -4,14 +4,23 @@
 #include <round.h>
 #include <stdint.h>
 
-/* Number of timer interrupts per second. */
-#define TIMER_FREQ 100
+/* Number of timer interrupts per second.
+   커널 명령줄 옵션 "-timer-freq=HZ"로 바꿀 수 있음. */
+#define TIMER_FREQ timer_freq
+#define TIMER_FREQ_DEFAULT 100
+#define TIMER_FREQ_MIN 19           /* 8254의 16비트 카운터 한계. */
+#define TIMER_FREQ_MAX 1000
+extern int timer_freq;
+
+/* 1초의 나노초 수. */
+#define NSEC_PER_SEC 1000000000LL
 
 void timer_init (void);
 void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_ns (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
@@ -0,0 +1,70 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+ *
+ * This is a leftist heap: a binary tree in which every node is
+ * no greater than its children and in which the right spine of
+ * every subtree has length O(log n).  Insertion, removal of the
+ * top element and removal of an arbitrary element all take
+ * O(log n) time, and merging is recursive only along right
+ * spines, so the recursion depth stays small enough for a
+ * kernel stack.
+ *
+ * Like the list and hash table, the heap does not use dynamic
+ * allocation.  Each structure that can potentially be in a heap
+ * must embed a struct heap_elem member, and heap_entry()
+ * converts a struct heap_elem back to the structure object that
+ * contains it.  Refer to lib/kernel/list.h for a detailed
+ * explanation of the technique.
+ *
+ * "Top" is the element for which no other element in the heap
+ * is less, as judged by the heap's less function.  Pass a
+ * greater-than function to get a max-heap. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *parent;   /* Parent node, or NULL at the root. */
+	struct heap_elem *left;     /* Left child (the higher rank one). */
+	struct heap_elem *right;    /* Right child. */
+	int rank;                   /* Length of the right spine. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+ * the structure that HEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->parent   \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b,
+		void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Top element, or NULL if empty. */
+	size_t elem_cnt;            /* Number of elements in the heap. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (const struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,17 @@
+#ifndef __LIB_SCHED_H
+#define __LIB_SCHED_H
+
+/* 스케줄링 클래스. 커널과 유저 프로그램이 함께 사용.
+
+   위에 있는 클래스의 준비된 스레드가 아래 클래스의 스레드보다 우선순위와
+   상관없이 항상 먼저 실행됨. SCHED_FIFO와 SCHED_RR은 같은 단계의 실시간
+   클래스라서 둘 사이에서는 우선순위로 비교하고, 같다면 SCHED_FIFO가 먼저. */
+enum sched_class {
+	SCHED_FIFO,             /* 실시간. 양보하거나 잠들 때까지 실행. */
+	SCHED_RR,               /* 실시간. 타임 슬라이스마다 같은 우선순위끼리 교대. */
+	SCHED_NORMAL,           /* 보통 스레드 (기본값). */
+	SCHED_IDLE,             /* 다른 클래스가 모두 놀 때만 실행. */
+	SCHED_CLASS_CNT
+};
+
+#endif /* lib/sched.h */
@@ -37,6 +37,14 @@ enum {
 	SYS_MOUNT,
 	SYS_UMOUNT,
 
+	/* 스케줄링. */
+	SYS_SCHED_SETCLASS,         /* 스케줄링 클래스와 우선순위 변경. */
+	SYS_CLONE,                  /* 주소 공간을 공유하는 스레드 생성. */
+
+	/* 유저 공간 동기화. */
+	SYS_FUTEX_WAIT,             /* 워드의 값이 바뀔 때까지 대기. */
+	SYS_FUTEX_WAKE,             /* 워드에서 기다리는 스레드를 깨움. */
+
 	SYS_END
 };
 
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <sched.h>
 #include <stddef.h>
 
 /* Process identifier. */
@@ -38,6 +39,17 @@ void close (int fd);
 
 int dup2(int oldfd, int newfd);
 
+/* 스케줄링. 실시간 클래스(SCHED_FIFO, SCHED_RR)는 커널을 "-user-rt"로 */
+/* 부팅했을 때만 쓸 수 있음 */
+int sched_setclass (enum sched_class cls, int priority);
+
+/* 스레드. FN(AUX)가 반환하면 스레드는 exit(0)으로 끝남. wait()로 기다림 */
+pid_t clone (void (*fn) (void *), void *aux);
+
+/* 유저 공간 동기화. */
+int futex_wait (int *addr, int expected);
+int futex_wake (int *addr, int n);
+
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
@@ -0,0 +1,96 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/spinlock.h"
+
+/* 지원하는 최대 CPU 수. */
+#define CPU_MAX 8
+
+/* 캐시 라인 크기 (바이트). CPU마다 따로 쓰는 데이터가 같은 줄을 */
+/* 나눠 쓰지 않도록 정렬하는 데 사용 */
+#define CACHE_LINE_SIZE 64
+
+/* CPU마다 재사용을 위해 남겨두는 스레드 페이지 수. */
+#define THREAD_CACHE_SIZE 8
+
+struct thread;
+struct task_state;
+
+/* CPU마다 하나씩 있는 상태.
+
+   부팅 CPU(BSP)가 cpus[0]이고, smp_init()이 깨운 나머지 CPU(AP)가
+   깨어난 순서대로 cpus[1]부터 차지함. 다른 CPU의 구조체를 읽을 때는
+   sched_lock 등 해당 필드를 보호하는 락을 잡아야 함. */
+struct cpu {
+	/* userprog/syscall-entry.S가 %gs 기준 고정 오프셋으로 접근하므로 */
+	/* 이 세 필드는 반드시 구조체 맨 앞에 이 순서대로 있어야 함. */
+	uint64_t syscall_rbx;               /* 0: syscall 진입 중 rbx 임시 저장. */
+	uint64_t syscall_r12;               /* 8: syscall 진입 중 r12 임시 저장. */
+	struct task_state *tss;             /* 16: 이 CPU의 TSS. */
+
+	int id;                             /* cpus[] 안의 인덱스. */
+	uint8_t lapic_id;                   /* Local APIC ID. */
+	volatile bool started;              /* AP가 초기화를 마쳤는지 여부. */
+
+	/* thread.c가 sched_lock으로 보호 */
+	struct thread *curr;                /* 이 CPU에서 실행 중인 스레드. */
+	struct thread *idle_thread;         /* 이 CPU의 idle 스레드. */
+	struct thread *prev;                /* 방금 전환되어 나간 스레드. */
+	unsigned thread_ticks;              /* 마지막 양보 후 지난 tick 수. */
+	int64_t acct_ns;                    /* CPU 시간을 마지막으로 정산한 시각. */
+
+	/* thread.c가 사용. 이 CPU에서 인터럽트를 끈 채로만 접근 */
+	void *thread_cache[THREAD_CACHE_SIZE]; /* 종료된 스레드의 페이지. */
+	int thread_cache_cnt;               /* thread_cache에 들어있는 페이지 수. */
+
+	/* interrupt.c가 사용. 외부 인터럽트 처리 중에는 인터럽트가 꺼져 있음 */
+	bool in_external_intr;              /* 외부 인터럽트 처리 중인지 여부. */
+	bool yield_on_return;               /* 인터럽트 반환 시 양보할지 여부. */
+
+	/* interrupt.c가 사용. intr_work_lock으로 보호 */
+	struct spinlock intr_work_lock;     /* 미뤄둔 작업 큐의 락. */
+	struct list intr_work;              /* 미뤄둔 작업(struct intr_work) 큐. */
+	struct thread *intr_worker;         /* 작업 큐를 비우는 스레드, 없으면 NULL. */
+	bool intr_worker_idle;              /* 작업 스레드가 잠들어 있는지 여부. */
+
+	/* fpu.c가 사용. 이 CPU에서 인터럽트를 끈 채로만 접근 */
+	struct thread *fpu_owner;           /* FPU 레지스터에 상태가 있는 스레드. */
+
+	/* 통계. */
+	long long idle_ticks;               /* idle 상태로 보낸 tick 수. */
+	long long kernel_ticks;             /* 커널 스레드가 쓴 tick 수. */
+	long long user_ticks;               /* 유저 프로그램이 쓴 tick 수. */
+	int64_t idle_ns;                    /* idle 상태로 보낸 시간 (나노초). */
+	int64_t kernel_ns;                  /* 커널 스레드가 쓴 시간 (나노초). */
+	int64_t user_ns;                    /* 유저 프로그램이 쓴 시간 (나노초). */
+	long long ipi_cnt;                  /* 받은 재스케줄 IPI 수. */
+	long long switch_cnt;               /* 스레드 전환 수. */
+	long long steal_cnt;                /* 다른 CPU에서 훔쳐온 스레드 수. */
+	long long migrate_cnt;              /* 다른 CPU에서 옮겨온 스레드 수. */
+	long long thread_cache_hits;        /* 재사용한 스레드 페이지 수. */
+	long long intr_work_cnt;            /* 미뤄둔 작업 수. */
+	long long intr_batch_cnt;           /* 작업 스레드가 깨어나 작업을 실행한 횟수. */
+	long long fpu_trap_cnt;             /* 처리한 #NM 수. */
+	long long fpu_restore_cnt;          /* FPU 상태를 복원한 횟수. */
+};
+
+/* 모든 CPU의 상태. 앞의 cpu_cnt개만 사용 중 */
+extern struct cpu cpus[CPU_MAX];
+
+/* 스케줄러에 참여하고 있는 CPU 수. */
+extern int cpu_cnt;
+
+/* AP를 하나라도 깨웠다면 true. 그 전에는 this_cpu()가 항상 cpus[0] */
+extern bool smp_started;
+
+struct cpu *this_cpu (void);
+
+void cpu_init (void);
+void smp_init (void);
+void cpu_kick (struct cpu *);
+
+#endif /* threads/cpu.h */
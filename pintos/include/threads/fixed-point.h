@@ -0,0 +1,88 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 고정소수점 연산.
+
+   커널은 부동소수점을 쓸 수 없으므로(-msoft-float, -mno-sse)
+   MLFQS의 load_avg, recent_cpu처럼 실수가 필요한 값은 정수의
+   하위 14비트를 소수부로 사용하는 고정소수점으로 표현함.
+   정수 N은 N * F로, 고정소수점 X는 X / F로 변환됨. */
+
+/* 고정소수점 값. */
+typedef int fixed_t;
+
+/* 소수부 비트 수. */
+#define FP_SHIFT 14
+
+/* 1.0에 해당하는 값. */
+#define FP_F (1 << FP_SHIFT)
+
+/* 정수 N을 고정소수점으로 변환 */
+static inline fixed_t
+fp_from_int (int n) {
+	return n * FP_F;
+}
+
+/* 고정소수점 X를 정수로 변환. 0 방향으로 버림 */
+static inline int
+fp_to_int (fixed_t x) {
+	return x / FP_F;
+}
+
+/* 고정소수점 X를 가장 가까운 정수로 반올림 */
+static inline int
+fp_round (fixed_t x) {
+	return 0 <= x ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+/* X + Y */
+static inline fixed_t
+fp_add (fixed_t x, fixed_t y) {
+	return x + y;
+}
+
+/* X - Y */
+static inline fixed_t
+fp_sub (fixed_t x, fixed_t y) {
+	return x - y;
+}
+
+/* X + N (N은 정수) */
+static inline fixed_t
+fp_add_int (fixed_t x, int n) {
+	return x + n * FP_F;
+}
+
+/* X - N (N은 정수) */
+static inline fixed_t
+fp_sub_int (fixed_t x, int n) {
+	return x - n * FP_F;
+}
+
+/* X * Y. 중간 결과가 넘치지 않도록 64비트로 계산 */
+static inline fixed_t
+fp_mul (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * y / FP_F;
+}
+
+/* X * N (N은 정수) */
+static inline fixed_t
+fp_mul_int (fixed_t x, int n) {
+	return x * n;
+}
+
+/* X / Y. 중간 결과가 넘치지 않도록 64비트로 계산 */
+static inline fixed_t
+fp_div (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * FP_F / y;
+}
+
+/* X / N (N은 정수) */
+static inline fixed_t
+fp_div_int (fixed_t x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed-point.h */
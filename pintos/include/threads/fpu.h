@@ -0,0 +1,30 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+
+struct thread;
+
+/* FXSAVE/FXRSTOR가 쓰는 x87, MMX, SSE 레지스터 상태.
+   [IA32-v2a] "FXSAVE" 참고. 16바이트 경계에 있어야 함 */
+struct fpu_state {
+	uint8_t data[512];
+} __attribute__ ((aligned (16)));
+
+void fpu_init (void);
+void fpu_init_ap (void);
+void fpu_print_stats (void);
+
+void fpu_switch (struct thread *prev);
+void fpu_save (void);
+bool fpu_fork (struct thread *child, const struct thread *parent);
+void fpu_release (struct thread *);
+void fpu_reset (void);
+
+enum intr_level fpu_kernel_begin (void);
+void fpu_kernel_end (enum intr_level);
+void fpu_copy_page (void *dst, const void *src);
+
+#endif /* threads/fpu.h */
@@ -1,6 +1,7 @@
 #ifndef THREADS_INTERRUPT_H
 #define THREADS_INTERRUPT_H
 
+#include <list.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -66,6 +67,7 @@ struct intr_frame {
 typedef void intr_handler_func (struct intr_frame *);
 
 void intr_init (void);
+void intr_init_ap (void);
 void intr_register_ext (uint8_t vec, intr_handler_func *, const char *name);
 void intr_register_int (uint8_t vec, int dpl, enum intr_level,
                         intr_handler_func *, const char *name);
@@ -75,4 +77,33 @@ void intr_yield_on_return (void);
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
 
+/* 인터럽트 핸들러가 미뤄둔 작업(하반부).
+
+   외부 인터럽트 핸들러(상반부)는 인터럽트가 꺼진 채로 실행되므로, 하드웨어를
+   건드리는 최소한의 일만 하고 나머지는 intr_defer()로 작업을 넣어 미룸.
+   작업은 핸들러를 실행한 CPU의 큐에 들어가고, 그 CPU의 작업 스레드가
+   인터럽트를 켠 채로 쌓인 작업을 한꺼번에 실행함. 작업 스레드는 자기 CPU에
+   고정되어 있고 가장 높은 순위(SCHED_FIFO, PRI_MAX)로 돌기 때문에 인터럽트가
+   반환되자마자 실행됨. 그 때문에 선점된 스레드는 자기 우선순위 리스트의 맨
+   앞에서 쓰던 타임 슬라이스를 이어가고(thread_yield_preempted()), 실시간
+   클래스를 세지 않는 MLFQS의 load_avg에도 잡히지 않음.
+
+   작업 함수는 보통 스레드 문맥에서 실행되므로 락을 잡을 수 있지만, 같은 큐의
+   다음 작업들을 늦추지 않도록 오래 잠들면 안 됨. 대기 중인 작업을 다시 넣으면
+   한 번만 실행되며, 실행 중에 다시 넣으면 한 번 더 실행됨.
+   struct intr_work는 호출자가 소유하며 대기 중인 동안에는 해제하면 안 됨. */
+typedef void intr_work_func (void *aux);
+
+struct intr_work {
+	struct list_elem elem;      /* CPU별 작업 큐 원소. */
+	intr_work_func *func;       /* 실행할 함수. */
+	void *aux;                  /* FUNC에 넘겨줄 인자. */
+	bool pending;               /* 작업 큐에 들어있는지 여부. */
+};
+
+void intr_work_init (struct intr_work *, intr_work_func *, void *aux);
+bool intr_defer (struct intr_work *);
+void intr_work_start (void);
+void intr_print_stats (void);
+
 #endif /* threads/interrupt.h */
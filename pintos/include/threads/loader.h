@@ -25,6 +25,10 @@
 #define LOADER_ARGS (LOADER_SIG - LOADER_ARGS_LEN)     /* Command-line args. */
 #define LOADER_ARG_CNT (LOADER_ARGS - LOADER_ARG_CNT_LEN) /* Number of args. */
 
+/* AP 부팅 코드(threads/ap-start.S)를 복사해 두는 물리 주소.
+   STARTUP IPI는 1MB 아래의 페이지 경계 주소만 가리킬 수 있음. */
+#define AP_TRAMPOLINE 0x8000
+
 /* Sizes of loader data structures. */
 #define LOADER_SIG_LEN 2
 #define LOADER_ARGS_LEN 128
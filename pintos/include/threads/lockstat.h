@@ -0,0 +1,29 @@
+#ifndef THREADS_LOCKSTAT_H
+#define THREADS_LOCKSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 락 경쟁 프로파일.
+
+   lock_stat_init()으로 등록한 통계를 lock_profile()이나 spinlock_profile()로
+   락에 붙여두면, 락을 얻을 때마다 횟수를 세고 놓을 때마다 잡고 있던
+   시간을 더함. 커널이 끝날 때 lock_stat_print()가 등록된 통계를 모두
+   출력하므로 어떤 락이 뜨거운지 알 수 있음.
+   필드는 락을 잡고 있는 쪽만 고치므로 따로 보호하지 않음. */
+struct lock_stat {
+	const char *name;           /* 출력할 이름. */
+	uint64_t acquire_cnt;       /* 획득 횟수. */
+	uint64_t contend_cnt;       /* 바로 얻지 못하고 기다린 횟수. */
+	uint64_t spin_cnt;          /* 기다린 것 중 잠들지 않고 돌면서 얻은 횟수. */
+	uint64_t hold_cycles;       /* 잡고 있던 시간의 합 (TSC 사이클). */
+	uint64_t acquired_at;       /* 마지막으로 얻은 시각 (TSC). */
+	struct lock_stat *next;     /* 다음으로 등록된 통계. */
+};
+
+void lock_stat_init (struct lock_stat *, const char *name);
+void lock_stat_acquired (struct lock_stat *, bool contended, bool spun);
+void lock_stat_released (struct lock_stat *);
+void lock_stat_print (void);
+
+#endif /* threads/lockstat.h */
@@ -0,0 +1,37 @@
+#ifndef THREADS_SCHED_TRACE_H
+#define THREADS_SCHED_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* 히스토그램 칸 수. 칸 i에는 [2^i, 2^(i+1)) TSC 사이클이 들어가고 */
+/* 마지막 칸에는 그보다 긴 값이 모두 들어감 */
+#define SCHED_TRACE_BUCKETS 40
+
+/* 스레드 하나의 스케줄링 기록.
+
+   준비 큐에 들어간 뒤 실행되기까지 기다린 시간과, 한 번 실행을
+   시작해서 CPU를 내놓을 때까지의 실행 구간 길이를 log2 히스토그램으로
+   모음. 스레드가 끝나도 출력할 수 있도록 기록은 해제하지 않음.
+   시각 필드와 히스토그램은 sched_lock으로 보호. */
+struct sched_trace {
+	int tid;                            /* 스레드 tid. */
+	char name[16];                      /* 스레드 이름. */
+	uint64_t ready_at;                  /* 준비 큐에 들어간 시각, 없다면 0. */
+	uint64_t run_at;                    /* 마지막으로 실행을 시작한 시각. */
+	uint32_t wait_hist[SCHED_TRACE_BUCKETS]; /* 준비 큐 대기 시간. */
+	uint32_t run_hist[SCHED_TRACE_BUCKETS];  /* 실행 구간 길이. */
+	struct sched_trace *next;           /* 다음으로 만들어진 기록. */
+};
+
+/* 커널 명령줄 옵션 "-sched-trace"로 켬 */
+extern bool sched_trace_enabled;
+
+void sched_trace_attach (struct thread *);
+void sched_trace_ready (struct thread *);
+void sched_trace_switch (struct thread *prev, struct thread *next);
+void sched_trace_print (void);
+
+#endif /* threads/sched-trace.h */
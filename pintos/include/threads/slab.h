@@ -0,0 +1,50 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/spinlock.h"
+
+/* 같은 크기의 커널 객체를 위한 슬랩 캐시.
+
+   malloc()은 요청 크기를 2의 거듭제곱으로 올리므로 크기가 고정된 객체는
+   블록의 절반 가까이를 버릴 수 있음. 슬랩 캐시는 한 페이지(슬랩)를 정확히
+   객체 크기로 나눠 쓰므로 같은 풀에 더 많은 객체가 들어감.
+
+   생성자가 있다면 슬랩을 만들 때 객체마다 한 번만 호출함. 객체를 돌려줄
+   때는 생성자가 만든 상태로 되돌려놓아야 하며, 다시 할당할 때는 생성자를
+   부르지 않음. 생성자는 캐시의 스핀락을 잡은 채로 불리므로 잠들면 안 됨.
+   할당과 해제는 인터럽트 핸들러에서도 할 수 있음. */
+
+/* 객체 생성자. */
+typedef void kmem_ctor_func (void *obj);
+
+/* 슬랩 캐시. kmem_cache_create()로 만듦 */
+struct kmem_cache {
+	const char *name;           /* 통계에 출력할 이름. */
+	size_t obj_size;            /* 정렬을 반영한 객체 크기. */
+	size_t align;               /* 객체 정렬 (바이트). */
+	size_t objs_per_slab;       /* 슬랩 하나에 들어가는 객체 수. */
+	size_t first_ofs;           /* 색칠하지 않은 슬랩에서 첫 객체의 오프셋. */
+	size_t colour_cnt;          /* 서로 다른 색 수. */
+	size_t colour_next;         /* 다음에 만들 슬랩의 색. */
+	kmem_ctor_func *ctor;       /* 생성자, 없다면 NULL. */
+
+	struct spinlock lock;       /* 아래 필드를 보호. */
+	struct list partial;        /* 일부만 쓰고 있는 슬랩. */
+	struct list full;           /* 모두 쓰고 있는 슬랩. */
+	struct list empty;          /* 하나도 쓰지 않는 슬랩. */
+	size_t slab_cnt;            /* 갖고 있는 슬랩 수. */
+	size_t inuse_cnt;           /* 할당된 객체 수. */
+	size_t peak_cnt;            /* INUSE_CNT의 최댓값. */
+
+	struct kmem_cache *next;    /* 다음으로 만들어진 캐시. */
+};
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor_func *ctor);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
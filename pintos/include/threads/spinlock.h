@@ -0,0 +1,39 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+#include "threads/interrupt.h"
+#include "threads/lockstat.h"
+
+struct cpu;
+
+/* 스핀락.
+
+   다른 CPU와의 경쟁만 막아주므로, 같은 CPU의 인터럽트 핸들러가 같은
+   락을 잡으려다 영원히 도는 일이 없도록 반드시 인터럽트를 끈 채로
+   잡아야 함. 잡고 있는 동안에는 잠들면 안 됨.
+   보통은 spin_lock_irqsave()와 spin_unlock_irqrestore()를 짝지어 씀. */
+struct spinlock {
+	volatile int locked;        /* 잡혀 있으면 1. */
+	struct cpu *holder;         /* 잡고 있는 CPU (디버깅용). */
+	const char *name;           /* 락 이름 (디버깅용). */
+	struct lock_stat *stat;     /* 경쟁 프로파일. 없다면 NULL. */
+};
+
+void spinlock_init (struct spinlock *, const char *name);
+void spinlock_profile (struct spinlock *, struct lock_stat *);
+void spin_lock (struct spinlock *);
+bool spin_trylock (struct spinlock *);
+void spin_unlock (struct spinlock *);
+bool spin_held (const struct spinlock *);
+
+enum intr_level spin_lock_irqsave (struct spinlock *);
+void spin_unlock_irqrestore (struct spinlock *, enum intr_level);
+
+/* 스핀 루프 안에서 다른 하이퍼스레드에게 실행 자원을 양보 */
+static inline void
+cpu_relax (void) {
+	asm volatile ("pause" : : : "memory");
+}
+
+#endif /* threads/spinlock.h */
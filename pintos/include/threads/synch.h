@@ -3,15 +3,19 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/spinlock.h"
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
 	struct list waiters;        /* List of waiting threads. */
+	struct spinlock lock;       /* value와 waiters를 보호. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
+bool sema_down_timeout (struct semaphore *, int64_t ticks);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
@@ -20,9 +24,19 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct lock_stat *stat;     /* 경쟁 프로파일. 없다면 NULL. */
 };
 
+/* 우선순위 기부를 따라 올라가는 기본 최대 깊이. */
+#define LOCK_DONATION_DEPTH 8
+extern int lock_donation_depth;
+
+/* 잠들기 전에 점유자가 락을 풀기를 기다리며 도는 기본 최대 횟수. */
+#define LOCK_SPIN_LIMIT 100
+extern int lock_spin_limit;
+
 void lock_init (struct lock *);
+void lock_profile (struct lock *, struct lock_stat *);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
@@ -35,9 +49,39 @@ struct condition {
 
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
+bool cond_wait_timeout (struct condition *, struct lock *, int64_t ticks);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock {
+	struct lock gate;           /* 쓰는 스레드가 쓰는 내내 잡고 있는 락. */
+	struct spinlock lock;       /* 아래 필드를 보호. */
+	unsigned readers;           /* 읽고 있는 스레드 수. */
+	unsigned writers;           /* 쓰고 있거나 쓰려고 기다리는 스레드 수. */
+	struct thread *drain_waiter; /* 읽는 스레드가 모두 빠지기를 기다리는 스레드. */
+	struct list holders;        /* 읽고 있는 스레드의 struct rwlock_hold 리스트. */
+};
+
+/* 스레드가 읽기 위해 잡고 있는 rwlock 하나. struct thread에 들어있음 */
+struct rwlock_hold {
+	struct list_elem elem;      /* rwlock의 holders 리스트 원소. */
+	struct rwlock *rw;          /* 잡고 있는 rwlock, 빈 칸이면 NULL. */
+	struct thread *thread;      /* 이 칸을 가진 스레드. */
+	unsigned depth;             /* 거듭 잡은 횟수. */
+};
+
+/* 한 스레드가 동시에 읽기 위해 잡은 rwlock을 기록하는 최대 개수. */
+/* 넘치는 rwlock은 기록하지 않으므로 그 읽는 스레드는 기부받지 못함 */
+#define RWLOCK_HOLD_MAX 2
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
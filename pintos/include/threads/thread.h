@@ -2,12 +2,14 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
+#include <sched.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
 #include "threads/interrupt.h"
-#ifdef USERPROG
-#include "synch.h"
-#endif
+#include "threads/spinlock.h"
+#include "threads/synch.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -31,6 +33,15 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness. */
+#define NICE_MIN -20                    /* Lowest niceness. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Highest niceness. */
+
+struct cpu;
+struct lock;
+struct process;
+
 /* 파일 디스크립터 테이블 크기 */
 #define FDT_COUNT_LIMIT 128
 
@@ -97,13 +108,41 @@ struct thread {
 	enum thread_status status;          /* Thread state. */
 	char name[16];                      /* Name (for debugging purposes). */
 	int priority;                       /* Priority. */
+	enum sched_class policy;            /* 스케줄링 클래스 (기부 반영). */
+	struct cpu *cpu;                    /* 실행 중이거나 준비 큐에 들어있는 CPU. */
+	struct cpu *run_cpu;                /* 마지막으로 이 스레드를 실행한 CPU, schedule()만 씀. */
+	struct cpu *bound_cpu;              /* 고정된 CPU, 어디서나 돌 수 있다면 NULL. */
+	unsigned slice_ticks;               /* 선점되기 전까지 쓴 타임 슬라이스 tick 수. */
+	struct sched_trace *trace;          /* 스케줄러 지연 기록, 없으면 NULL. */
+	struct fpu_state *fpu;              /* FPU 상태, FPU를 쓴 적이 없다면 NULL. */
+	struct cpu *fpu_cpu;                /* 마지막으로 FPU를 쓴 CPU. */
+
+	/* 우선순위 기부에서 사용 (synch.c와 공유) */
+	int base_priority;                  /* 기부받기 전 원래 우선순위. */
+	enum sched_class base_policy;       /* 기부받기 전 원래 스케줄링 클래스. */
+	struct lock *wait_on_lock;          /* 획득하려고 기다리는 락. */
+	struct thread *donee;               /* 자신이 기부 중인 스레드, 없으면 NULL. */
+	struct heap donors;                 /* 기부해준 스레드들의 최대 힙. */
+	struct heap_elem donor_elem;        /* donee의 donors 힙 원소. */
+	struct rwlock_hold rw_holds[RWLOCK_HOLD_MAX]; /* 읽기 위해 잡은 rwlock. */
+
+	/* MLFQS 스케줄러에서 사용 */
+	int nice;                           /* 다른 스레드에게 양보하는 정도. */
+	fixed_t recent_cpu;                 /* 최근에 사용한 CPU 시간. */
+	int64_t recent_cpu_epoch;           /* recent_cpu에 감쇠가 반영된 마지막 초. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
 
+	/* Owned by devices/timer.c. */
+	int64_t wakeup_tick;                /* 깨어나야 하는 tick. */
+	struct heap_elem sleep_elem;        /* 수면 큐(최소 힙) 원소. */
+
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4;                     /* Page map level 4 */
+	struct process *proc;               /* 속한 프로세스. 커널 스레드는 NULL. */
+	void *user_stack;                   /* clone()이 만든 유저 스택 페이지, 없으면 NULL. */
 
 	/* 부모 프로세스 */
 	struct thread* parent;
@@ -121,23 +160,11 @@ struct thread {
 	/* wait() 중복 호출 방지 플래그 */
 	bool is_waited;
 
-	/* 파일 식별자를 저장할 테이블 */
-	/* 프로세스당 최소 2개에서 최대 64개의 파일을 저장할 수 있어야 함. */
-	/* 대부분의 PintOS 프로젝트 명세에서는 2개에서 64개까지를 요구하기 때문에 넉넉하게 128 사용 */
-	struct file* fd_table[FDT_COUNT_LIMIT];
-
 	/* fork 동기화를 위한 세마포어 */
 	struct semaphore fork_sema;
 	/* 부모의 유저 스택 정보를 자식에게 전달하기 위한 포인터 */
 	struct intr_frame* parent_if;
-
-	/* 프로세스가 종료될 때 파일을 닫기 위한 실행 파일 포인터 */
-	struct file* exec_file;
 #endif	
-#ifdef VM
-	/* Table for whole virtual memory owned by thread. */
-	struct supplemental_page_table spt;
-#endif
 
 	/* Owned by thread.c. */
 	struct intr_frame tf;               /* Information for switching */
@@ -149,8 +176,18 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* 타임 슬라이스 (밀리초). 커널 명령줄 옵션 "-time-slice=MS"로 바꿀 수 있음 */
+#define TIME_SLICE_MS_MIN 1
+#define TIME_SLICE_MS_MAX 1000
+extern int thread_time_slice_ms;
+
+/* 모든 CPU의 준비 큐, 스레드 상태 전이, 우선순위 기부 정보를 보호하는 락. */
+extern struct spinlock sched_lock;
+
 void thread_init (void);
 void thread_start (void);
+void thread_init_ap (struct cpu *);
+void thread_idle_ap (void) NO_RETURN;
 
 void thread_tick (void);
 void thread_print_stats (void);
@@ -159,6 +196,7 @@ typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
 void thread_block (void);
+void thread_block_unlock (struct spinlock *);
 void thread_unblock (struct thread *);
 
 struct thread *thread_current (void);
@@ -167,9 +205,17 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_yield_preempted (void);
+void thread_bind_cpu (struct cpu *);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+enum sched_class thread_get_class (void);
+bool thread_set_class (enum sched_class, int priority);
+int thread_rank (const struct thread *);
+bool thread_refresh_priority (struct thread *);
+bool thread_should_preempt (const struct thread *);
+void thread_preempt (void);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
@@ -0,0 +1,8 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+void futex_init (void);
+int futex_wait (int *kaddr, int expected);
+int futex_wake (int *kaddr, int n);
+
+#endif /* userprog/futex.h */
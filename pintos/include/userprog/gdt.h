@@ -4,5 +4,6 @@
 #include "threads/loader.h"
 
 void gdt_init (void);
+void gdt_init_ap (void);
 
 #endif /* userprog/gdt.h */
@@ -2,9 +2,42 @@
 #define USERPROG_PROCESS_H
 
 #include "threads/thread.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/* 유저 프로세스.
+
+   같은 주소 공간에서 도는 스레드들이 함께 쓰는 자원을 담음. fork()는
+   새 프로세스를 만들고, clone()으로 만든 스레드는 부모의 프로세스를
+   공유함. 이 프로세스를 가리키는 스레드 수를 세다가 마지막 스레드가
+   종료될 때 주소 공간과 열린 파일을 모두 정리함. */
+struct process {
+	int refcnt;                         /* 이 프로세스에 속한 스레드 수. */
+	tid_t pid;                          /* 처음 스레드의 tid. */
+	uint64_t *pml4;                     /* 공유하는 페이지 테이블. */
+
+	/* 파일 식별자를 저장할 테이블 */
+	/* 프로세스당 최소 2개에서 최대 64개의 파일을 저장할 수 있어야 함. */
+	/* 대부분의 PintOS 프로젝트 명세에서는 2개에서 64개까지를 요구하기 때문에 넉넉하게 128 사용 */
+	struct file *fd_table[FDT_COUNT_LIMIT];
+
+	/* 프로세스가 종료될 때 파일을 닫기 위한 실행 파일 포인터 */
+	struct file *exec_file;
+
+	/* clone()이 유저 스택 자리를 고르는 동안 잡음 */
+	struct lock stack_lock;
+	uint64_t stack_map;                 /* 쓰고 있는 clone 스택 자리의 비트맵. */
+#ifdef VM
+	/* Table for whole virtual memory owned by process. */
+	struct supplemental_page_table spt;
+#endif
+};
 
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
+tid_t process_clone (const char *name, struct intr_frame *if_,
+		uint64_t entry, uint64_t arg0, uint64_t arg1);
 int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
@@ -1,6 +1,13 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+
+/* 유저 프로그램이 실시간 클래스를 쓸 수 있는지 여부. */
+/* 커널 명령줄 옵션 "-user-rt"로 켬 */
+extern bool user_rt_allowed;
+
 void syscall_init (void);
+void syscall_init_ap (void);
 
 #endif /* userprog/syscall.h */
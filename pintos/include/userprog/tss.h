@@ -24,6 +24,7 @@ struct task_state {
 
 struct task_state;
 void tss_init (void);
+void tss_init_ap (void);
 struct task_state *tss_get (void);
 void tss_update (struct thread *next);
 
@@ -1,7 +1,11 @@
 #ifndef VM_VM_H
 #define VM_VM_H
+#include <hash.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "threads/palloc.h"
+#include "threads/synch.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -46,6 +50,7 @@ struct page {
 	struct frame *frame;   /* Back reference for frame */
 
 	/* Your implementation */
+	struct hash_elem spt_elem;  /* supplemental_page_table의 해시 원소. */
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -81,21 +86,46 @@ struct page_operations {
 #define destroy(page) \
 	if ((page)->operations->destroy) (page)->operations->destroy (page)
 
+/* 연속으로 매핑된 유저 페이지 구간 [start, end). */
+struct spt_run {
+	uintptr_t start;
+	uintptr_t end;
+};
+
 /* Representation of current process's memory space.
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
+/* 페이지 폴트에서 쓰는 VA -> struct page 조회는 페이지 시작 주소를 키로 하는
+ * 해시 테이블로 O(1)에 처리함. mmap의 겹침 검사와 munmap처럼 주소 구간을
+ * 다루는 연산을 위해 매핑된 페이지들을 연속 구간(run)으로 묶어 시작 주소
+ * 순으로 정렬한 배열도 함께 둠. 구간 연산은 이진 탐색으로 첫 구간을 찾고
+ * 겹치는 구간 안의 페이지만 보므로, 매핑되지 않은 빈 주소를 한 페이지씩
+ * 확인하지 않음. 구간을 나눌 메모리가 없을 때는 나누지 않고 두므로 구간은
+ * 매핑되지 않은 페이지를 포함할 수 있음. 그래서 구간 안의 페이지도 항상
+ * 해시 테이블로 다시 확인함.
+ * 프로세스의 모든 스레드가 공유하므로 lock으로 보호함. */
 struct supplemental_page_table {
+	struct rwlock lock;         /* 아래 필드를 보호. */
+	struct hash pages;          /* 매핑된 struct page, 키는 va. */
+	struct spt_run *runs;       /* 시작 주소 순으로 정렬한 구간 배열. */
+	size_t run_cnt;             /* runs의 구간 수. */
+	size_t run_cap;             /* runs에 할당된 원소 수. */
 };
 
 #include "threads/thread.h"
-void supplemental_page_table_init (struct supplemental_page_table *spt);
+bool supplemental_page_table_init (struct supplemental_page_table *spt);
 bool supplemental_page_table_copy (struct supplemental_page_table *dst,
 		struct supplemental_page_table *src);
 void supplemental_page_table_kill (struct supplemental_page_table *spt);
+void supplemental_page_table_destroy (struct supplemental_page_table *spt);
 struct page *spt_find_page (struct supplemental_page_table *spt,
 		void *va);
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
+bool spt_overlaps (struct supplemental_page_table *spt, void *start,
+		size_t page_cnt);
+size_t spt_remove_range (struct supplemental_page_table *spt, void *start,
+		size_t page_cnt);
 
 void vm_init (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
@@ -0,0 +1,158 @@
+/* Leftist heap.
+
+   See heap.h for basic information. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *merge (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static int rank (const struct heap_elem *);
+
+/* Initializes H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->parent = e->left = e->right = NULL;
+	e->rank = 1;
+
+	h->root = merge (h, h->root, e);
+	h->root->parent = NULL;
+	h->elem_cnt++;
+}
+
+/* Returns the top element of H, or a null pointer if H is
+   empty. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root;
+}
+
+/* Removes and returns the top element of H.  H must not be
+   empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top;
+
+	ASSERT (!heap_empty (h));
+
+	top = h->root;
+	h->root = merge (h, top->left, top->right);
+	if (h->root != NULL)
+		h->root->parent = NULL;
+	h->elem_cnt--;
+
+	top->parent = top->left = top->right = NULL;
+	return top;
+}
+
+/* Removes E, which must be in H, from H.
+
+   To change the key of an element, remove it, update the key and
+   push it back. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *parent, *sub, *n;
+
+	ASSERT (!heap_empty (h));
+	ASSERT (e != NULL);
+
+	if (e == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	/* Replace E by the merge of its children. */
+	parent = e->parent;
+	sub = merge (h, e->left, e->right);
+	if (parent->left == e)
+		parent->left = sub;
+	else
+		parent->right = sub;
+	if (sub != NULL)
+		sub->parent = parent;
+	h->elem_cnt--;
+
+	/* Restore the leftist property on the path to the root.  Ranks
+	   only shrink here, so we can stop as soon as one is stable. */
+	for (n = parent; n != NULL; n = n->parent) {
+		int new_rank;
+
+		if (rank (n->left) < rank (n->right)) {
+			struct heap_elem *tmp = n->left;
+			n->left = n->right;
+			n->right = tmp;
+		}
+		new_rank = rank (n->right) + 1;
+		if (new_rank == n->rank)
+			break;
+		n->rank = new_rank;
+	}
+
+	e->parent = e->left = e->right = NULL;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	return h->elem_cnt == 0;
+}
+
+/* Merges the heaps rooted at A and B and returns the new root.
+   The parent pointer of the returned root is left for the caller
+   to set. */
+static struct heap_elem *
+merge (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	struct heap_elem *tmp;
+
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	/* Keep the smaller root on top. */
+	if (h->less (b, a, h->aux)) {
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	a->right = merge (h, a->right, b);
+	a->right->parent = a;
+	if (rank (a->left) < rank (a->right)) {
+		tmp = a->left;
+		a->left = a->right;
+		a->right = tmp;
+	}
+	a->rank = rank (a->right) + 1;
+	return a;
+}
+
+/* Returns the rank of E, treating a null pointer as rank 0. */
+static int
+rank (const struct heap_elem *e) {
+	return e != NULL ? e->rank : 0;
+}
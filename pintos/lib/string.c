@@ -1,5 +1,83 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* 워드 단위 처리.
+
+   아래 함수들은 8바이트 워드 단위로 복사, 채우기, 비교를 함. 먼저 목적지가
+   워드 경계에 맞을 때까지 바이트 단위로 처리하고(prologue), 워드 단위로
+   처리한 뒤, 남은 바이트를 다시 바이트 단위로 처리함(epilogue). x86-64는
+   정렬되지 않은 읽기를 허용하므로 원본 쪽은 정렬을 맞추지 않음.
+   REP_MIN 바이트 이상이면 워드 루프 대신 rep movsq/stosq를 씀. 페이지
+   복사(fork의 duplicate_pte)와 페이지 채우기가 여기에 해당함. */
+
+/* 다른 타입의 객체를 가리켜도 되는 워드. */
+typedef uint64_t word_t __attribute__ ((may_alias));
+
+#define WORD_SIZE sizeof (word_t)
+
+/* rep movsq/stosq를 쓰기 시작하는 크기. */
+#define REP_MIN 256
+
+/* 모든 바이트가 0x01, 0x80인 워드. */
+#define ONES ((word_t) 0x0101010101010101ULL)
+#define HIGHS ((word_t) 0x8080808080808080ULL)
+
+/* 워드 W에 0인 바이트가 있다면 0이 아닌 값. */
+#define HAS_ZERO(W) (((W) - ONES) & ~(W) & HIGHS)
+
+/* SRC에서 DST로 SIZE 바이트를 앞에서부터 복사. DST가 SRC보다 앞에
+   있다면 겹쳐도 됨. */
+static void
+copy_forward (unsigned char *dst, const unsigned char *src, size_t size) {
+	if (size >= WORD_SIZE) {
+		while ((uintptr_t) dst % WORD_SIZE != 0) {
+			*dst++ = *src++;
+			size--;
+		}
+
+		if (size >= REP_MIN) {
+			size_t cnt = size / WORD_SIZE;
+
+			asm volatile ("rep movsq"
+					: "+D" (dst), "+S" (src), "+c" (cnt) : : "memory");
+			size %= WORD_SIZE;
+		} else {
+			for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+				*(word_t *) dst = *(const word_t *) src;
+				dst += WORD_SIZE;
+				src += WORD_SIZE;
+			}
+		}
+	}
+
+	while (size-- > 0)
+		*dst++ = *src++;
+}
+
+/* SRC에서 DST로 SIZE 바이트를 뒤에서부터 복사. DST가 SRC보다 뒤에
+   있다면 겹쳐도 됨. */
+static void
+copy_backward (unsigned char *dst, const unsigned char *src, size_t size) {
+	dst += size;
+	src += size;
+
+	if (size >= WORD_SIZE) {
+		while ((uintptr_t) dst % WORD_SIZE != 0) {
+			*--dst = *--src;
+			size--;
+		}
+
+		for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+			dst -= WORD_SIZE;
+			src -= WORD_SIZE;
+			*(word_t *) dst = *(const word_t *) src;
+		}
+	}
+
+	while (size-- > 0)
+		*--dst = *--src;
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -11,8 +89,7 @@ memcpy (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = *src++;
+	copy_forward (dst, src, size);
 
 	return dst_;
 }
@@ -27,17 +104,12 @@ memmove (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	if (dst < src) {
-		while (size-- > 0)
-			*dst++ = *src++;
-	} else {
-		dst += size;
-		src += size;
-		while (size-- > 0)
-			*--dst = *--src;
-	}
+	if (dst < src)
+		copy_forward (dst, src, size);
+	else
+		copy_backward (dst, src, size);
 
-	return dst;
+	return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -52,6 +124,14 @@ memcmp (const void *a_, const void *b_, size_t size) {
 	ASSERT (a != NULL || size == 0);
 	ASSERT (b != NULL || size == 0);
 
+	/* 같은 워드는 건너뛰고, 다른 워드는 아래에서 바이트 단위로 비교 */
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		if (*(const word_t *) a != *(const word_t *) b)
+			break;
+		a += WORD_SIZE;
+		b += WORD_SIZE;
+	}
+
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -260,6 +340,28 @@ memset (void *dst_, int value, size_t size) {
 
 	ASSERT (dst != NULL || size == 0);
 
+	if (size >= WORD_SIZE) {
+		word_t word = ONES * (unsigned char) value;
+
+		while ((uintptr_t) dst % WORD_SIZE != 0) {
+			*dst++ = value;
+			size--;
+		}
+
+		if (size >= REP_MIN) {
+			size_t cnt = size / WORD_SIZE;
+
+			asm volatile ("rep stosq"
+					: "+D" (dst), "+c" (cnt) : "a" (word) : "memory");
+			size %= WORD_SIZE;
+		} else {
+			for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+				*(word_t *) dst = word;
+				dst += WORD_SIZE;
+			}
+		}
+	}
+
 	while (size-- > 0)
 		*dst++ = value;
 
@@ -273,8 +375,16 @@ strlen (const char *string) {
 
 	ASSERT (string);
 
-	for (p = string; *p != '\0'; p++)
-		continue;
+	/* 워드 경계까지는 바이트 단위로 보고, 그 뒤로는 0인 바이트가 있는 */
+	/* 워드를 찾음. 정렬된 워드는 페이지 경계를 넘지 않으므로 문자열 */
+	/* 끝을 지나 읽어도 안전함 */
+	for (p = string; (uintptr_t) p % WORD_SIZE != 0; p++)
+		if (*p == '\0')
+			return p - string;
+	while (!HAS_ZERO (*(const word_t *) p))
+		p += WORD_SIZE;
+	while (*p != '\0')
+		p++;
 	return p - string;
 }
 
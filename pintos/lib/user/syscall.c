@@ -194,3 +194,31 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+sched_setclass (enum sched_class cls, int priority) {
+	return syscall2 (SYS_SCHED_SETCLASS, cls, priority);
+}
+
+int
+futex_wait (int *addr, int expected) {
+	return syscall2 (SYS_FUTEX_WAIT, addr, expected);
+}
+
+int
+futex_wake (int *addr, int n) {
+	return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+/* clone()으로 만든 스레드가 처음 실행하는 곳. 커널은 rsp가 16바이트
+   정렬에서 8만큼 어긋난 상태(함수 호출 직후와 같음)로 여기 진입시킴. */
+static void
+clone_start (void (*fn) (void *), void *aux) {
+	fn (aux);
+	exit (0);
+}
+
+pid_t
+clone (void (*fn) (void *), void *aux) {
+	return syscall3 (SYS_CLONE, clone_start, fn, aux);
+}
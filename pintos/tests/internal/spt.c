@@ -0,0 +1,105 @@
+/* Test program for the supplemental page table in vm/vm.c.
+
+   Maps 1K, 64K and 1M pages into a supplemental page table, checks
+   that every page can be found and that range queries see exactly
+   the mapped pages, then measures how many spt_find_page() calls
+   complete per second on random mapped addresses.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/test.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+/* First user address that we map. */
+#define BASE ((uint8_t *) 0x10000000)
+
+/* Length of each throughput measurement in nanoseconds. */
+#define BENCH_NS 100000000
+
+static void test_size (size_t page_cnt);
+
+/* Test the supplemental page table. */
+void
+test (void)
+{
+  test_size (1024);
+  test_size (64 * 1024);
+  test_size (1024 * 1024);
+}
+
+/* Maps PAGE_CNT pages, leaving every 16th page unmapped so that
+   the table holds many separate runs, and measures lookups. */
+static void
+test_size (size_t page_cnt)
+{
+  struct supplemental_page_table spt;
+  struct page *pages;
+  int64_t start, lookup_cnt;
+  size_t i;
+
+  pages = malloc (page_cnt * sizeof *pages);
+  if (pages == NULL)
+    {
+      printf ("%zu pages: skipped, out of memory\n", page_cnt);
+      return;
+    }
+
+  if (!supplemental_page_table_init (&spt))
+    {
+      printf ("%zu pages: skipped, out of memory\n", page_cnt);
+      free (pages);
+      return;
+    }
+  for (i = 0; i < page_cnt; i++)
+    {
+      pages[i].va = BASE + i * PGSIZE;
+      if (i % 16 != 15 && !spt_insert_page (&spt, &pages[i]))
+        {
+          printf ("%zu pages: skipped, out of memory\n", page_cnt);
+          goto done;
+        }
+    }
+
+  /* Every mapped page is found at any offset; holes are not. */
+  for (i = 0; i < page_cnt; i++)
+    {
+      struct page *p = spt_find_page (&spt, BASE + i * PGSIZE + i % PGSIZE);
+      ASSERT (p == (i % 16 != 15 ? &pages[i] : NULL));
+    }
+  ASSERT (!spt_insert_page (&spt, &pages[0]));
+
+  /* Range queries only report mapped pages. */
+  ASSERT (spt_overlaps (&spt, BASE, page_cnt));
+  ASSERT (!spt_overlaps (&spt, BASE + 15 * PGSIZE, 1));
+  ASSERT (!spt_overlaps (&spt, BASE + page_cnt * PGSIZE, page_cnt));
+  ASSERT (spt_overlaps (&spt, BASE + 15 * PGSIZE, 2));
+
+  for (lookup_cnt = 0, start = timer_ns (); timer_ns () - start < BENCH_NS; )
+    {
+      size_t idx = random_ulong () % page_cnt;
+
+      spt_find_page (&spt, BASE + idx * PGSIZE);
+      lookup_cnt++;
+    }
+  printf ("%zu pages: %lld lookups/s\n", page_cnt,
+          lookup_cnt * (1000000000 / BENCH_NS));
+
+ done:
+  /* The pages are one array, so empty the table without freeing
+     each page. */
+  hash_clear (&spt.pages, NULL);
+  free (spt.runs);
+  spt.runs = NULL;
+  spt.run_cnt = spt.run_cap = 0;
+  supplemental_page_table_destroy (&spt);
+  free (pages);
+}
@@ -0,0 +1,165 @@
+/* Test program for the block functions in lib/string.c.
+
+   Checks memcpy(), memmove(), memset(), memcmp() and strlen()
+   against simple byte-at-a-time versions at every alignment, then
+   compares the throughput of both at 16, 512 and 4096 bytes.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+
+/* Largest block that we will test, plus room for misalignment
+   and overlap. */
+#define MAX_SIZE 4096
+#define BUF_SIZE (MAX_SIZE + 64)
+
+/* Length of each throughput measurement in nanoseconds. */
+#define BENCH_NS 100000000
+
+static unsigned char a[BUF_SIZE], b[BUF_SIZE], c[BUF_SIZE];
+
+static void *byte_memcpy (void *, const void *, size_t);
+static void *byte_memset (void *, int, size_t);
+static int byte_memcmp (const void *, const void *, size_t);
+static void verify (size_t size);
+static void bench (size_t size);
+
+/* Test the block functions. */
+void
+test (void)
+{
+  static const size_t bench_sizes[] = {16, 512, 4096};
+  size_t size, i;
+
+  printf ("testing sizes:");
+  for (size = 0; size <= MAX_SIZE; size = size * 4 / 3 + 1)
+    {
+      printf (" %zu", size);
+      verify (size);
+    }
+  verify (MAX_SIZE);
+  printf (" done\n");
+
+  for (i = 0; i < sizeof bench_sizes / sizeof *bench_sizes; i++)
+    bench (bench_sizes[i]);
+}
+
+/* Checks each function on SIZE-byte blocks at all 8x8
+   source and destination alignments. */
+static void
+verify (size_t size)
+{
+  size_t src_ofs, dst_ofs, i;
+
+  for (src_ofs = 0; src_ofs < 8; src_ofs++)
+    for (dst_ofs = 0; dst_ofs < 8; dst_ofs++)
+      {
+        random_bytes (a, sizeof a);
+        random_bytes (b, sizeof b);
+        byte_memcpy (c, b, sizeof c);
+
+        /* memcpy(). */
+        ASSERT (memcpy (b + dst_ofs, a + src_ofs, size) == b + dst_ofs);
+        byte_memcpy (c + dst_ofs, a + src_ofs, size);
+        ASSERT (!byte_memcmp (b, c, sizeof b));
+
+        /* memmove(), overlapping in both directions. */
+        ASSERT (memmove (b + dst_ofs, b + src_ofs + 16, size)
+                == b + dst_ofs);
+        for (i = 0; i < size; i++)
+          c[dst_ofs + i] = c[src_ofs + 16 + i];
+        ASSERT (!byte_memcmp (b, c, sizeof b));
+        memmove (b + src_ofs + 16, b + dst_ofs, size);
+        for (i = size; i-- > 0; )
+          c[src_ofs + 16 + i] = c[dst_ofs + i];
+        ASSERT (!byte_memcmp (b, c, sizeof b));
+
+        /* memset(). */
+        ASSERT (memset (b + dst_ofs, src_ofs * 37, size) == b + dst_ofs);
+        byte_memset (c + dst_ofs, src_ofs * 37, size);
+        ASSERT (!byte_memcmp (b, c, sizeof b));
+
+        /* memcmp(), with one byte changed. */
+        byte_memcpy (b, a, sizeof b);
+        ASSERT (memcmp (a + src_ofs, b + src_ofs, size) == 0);
+        if (size > 0)
+          {
+            b[src_ofs + random_ulong () % size] ^= 1 + random_ulong () % 255;
+            ASSERT (memcmp (a + src_ofs, b + src_ofs, size)
+                    == byte_memcmp (a + src_ofs, b + src_ofs, size));
+          }
+
+        /* strlen(). */
+        byte_memset (c, 'x', sizeof c);
+        c[src_ofs + size] = '\0';
+        ASSERT (strlen ((char *) c + src_ofs) == size);
+      }
+}
+
+/* Prints how many bytes per second memcpy() and memset() move
+   in SIZE-byte blocks, next to the byte-at-a-time versions. */
+static void
+bench (size_t size)
+{
+  int64_t start, fast_cnt, slow_cnt;
+
+  for (fast_cnt = 0, start = timer_ns (); timer_ns () - start < BENCH_NS; )
+    memcpy (b + 1, a, size), fast_cnt++;
+  for (slow_cnt = 0, start = timer_ns (); timer_ns () - start < BENCH_NS; )
+    byte_memcpy (b + 1, a, size), slow_cnt++;
+  printf ("memcpy %4zu bytes: %lld MB/s (byte loop %lld MB/s)\n", size,
+          fast_cnt * size * (1000000000 / BENCH_NS) / 1000000,
+          slow_cnt * size * (1000000000 / BENCH_NS) / 1000000);
+
+  for (fast_cnt = 0, start = timer_ns (); timer_ns () - start < BENCH_NS; )
+    memset (b + 1, 0, size), fast_cnt++;
+  for (slow_cnt = 0, start = timer_ns (); timer_ns () - start < BENCH_NS; )
+    byte_memset (b + 1, 0, size), slow_cnt++;
+  printf ("memset %4zu bytes: %lld MB/s (byte loop %lld MB/s)\n", size,
+          fast_cnt * size * (1000000000 / BENCH_NS) / 1000000,
+          slow_cnt * size * (1000000000 / BENCH_NS) / 1000000);
+}
+
+/* Byte-at-a-time memcpy(). */
+static void *
+byte_memcpy (void *dst_, const void *src_, size_t size)
+{
+  unsigned char *dst = dst_;
+  const unsigned char *src = src_;
+
+  while (size-- > 0)
+    *dst++ = *src++;
+  return dst_;
+}
+
+/* Byte-at-a-time memset(). */
+static void *
+byte_memset (void *dst_, int value, size_t size)
+{
+  unsigned char *dst = dst_;
+
+  while (size-- > 0)
+    *dst++ = value;
+  return dst_;
+}
+
+/* Byte-at-a-time memcmp(). */
+static int
+byte_memcmp (const void *a_, const void *b_, size_t size)
+{
+  const unsigned char *a = a_;
+  const unsigned char *b = b_;
+
+  for (; size-- > 0; a++, b++)
+    if (*a != *b)
+      return *a > *b ? +1 : -1;
+  return 0;
+}
@@ -0,0 +1,80 @@
+/* Measures malloc() and free() throughput.
+
+   Runs 1, 2, 3 and 4 threads for a fixed time.  Each thread keeps
+   a small set of live blocks of mixed sizes and keeps replacing
+   them, so most calls hit the calling CPU's magazine and only a
+   few reach the shared free lists.  Reports how many malloc() and
+   free() calls completed per second.  With enough CPUs online the
+   rate should grow with the thread count.  Every thread also tags
+   its blocks and checks the tag before freeing, to catch a block
+   handed out twice. */
+
+#include <stdio.h>
+#include "tests/threads/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+/* Largest number of threads in one round. */
+#define MAX_THREADS 4
+
+/* Number of blocks each thread keeps allocated. */
+#define LIVE_CNT 32
+
+/* Blocks whose tag was overwritten. */
+static int corrupt;
+
+static bench_func malloc_worker;
+
+void
+test_bench_malloc (void) 
+{
+  int cnt;
+
+  bench_begin ();
+  for (cnt = 1; cnt <= MAX_THREADS; cnt++) 
+    {
+      int64_t ops;
+
+      corrupt = 0;
+      ops = bench_round ("malloc", cnt, malloc_worker, NULL);
+      if (corrupt > 0)
+        fail ("%d blocks were handed out twice", corrupt);
+      msg ("%d threads: %lld ops/s", cnt,
+           ops * TIMER_FREQ / BENCH_ROUND_TICKS);
+    }
+}
+
+static int64_t
+malloc_worker (int id, void *aux UNUSED) 
+{
+  static const size_t sizes[] = {16, 24, 40, 64, 100, 200, 500};
+  unsigned char *live[LIVE_CNT] = {NULL};
+  unsigned char tag = id + 1;
+  int64_t ops = 0;
+  size_t n = 0;
+  int i;
+
+  while (!bench_stopped ()) 
+    {
+      size_t slot = n % LIVE_CNT;
+
+      if (live[slot] != NULL) 
+        {
+          if (live[slot][0] != tag)
+            __atomic_add_fetch (&corrupt, 1, __ATOMIC_RELAXED);
+          free (live[slot]);
+          ops++;
+        }
+
+      live[slot] = malloc (sizes[n % (sizeof sizes / sizeof *sizes)]);
+      if (live[slot] == NULL)
+        fail ("out of memory in thread %d", id);
+      live[slot][0] = tag;
+      ops++;
+      n++;
+    }
+
+  for (i = 0; i < LIVE_CNT; i++)
+    free (live[i]);
+  return ops;
+}
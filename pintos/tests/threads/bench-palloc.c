@@ -0,0 +1,72 @@
+/* Measures how much the per-CPU page caches speed up palloc.
+
+   Runs 1, 2, 3 and 4 threads for a fixed time, twice.  In the
+   first pass every thread allocates and frees single user pages,
+   which come from and go back to the calling CPU's page cache.
+   In the second pass the threads allocate two pages at a time,
+   which always takes the pool lock.  Reports how many pages
+   passed through palloc per second in each pass.  With enough
+   CPUs online the cached rate should grow with the thread count
+   while the uncached rate stays flat. */
+
+#include <stdio.h>
+#include "tests/threads/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+
+/* Largest number of threads in one round. */
+#define MAX_THREADS 4
+
+/* Number of allocations each thread keeps live. */
+#define LIVE_CNT 16
+
+static bench_func palloc_worker;
+
+void
+test_bench_palloc (void) 
+{
+  int cnt;
+
+  bench_begin ();
+  for (cnt = 1; cnt <= MAX_THREADS; cnt++) 
+    {
+      static size_t page_cnts[] = {1, 2};
+      int64_t rates[2];
+      int i;
+
+      for (i = 0; i < 2; i++)
+        rates[i] = bench_round ("palloc", cnt, palloc_worker, &page_cnts[i])
+                   * TIMER_FREQ / BENCH_ROUND_TICKS;
+      msg ("%d threads: %lld pages/s cached, %lld pages/s uncached",
+           cnt, rates[0], rates[1]);
+    }
+}
+
+/* Keeps replacing LIVE_CNT allocations of *PAGE_CNT_ pages each
+   and returns the number of pages allocated and freed. */
+static int64_t
+palloc_worker (int id, void *page_cnt_) 
+{
+  size_t page_cnt = *(size_t *) page_cnt_;
+  void *live[LIVE_CNT] = {NULL};
+  int64_t pages = 0;
+  size_t n = 0;
+  int i;
+
+  while (!bench_stopped ()) 
+    {
+      size_t slot = n++ % LIVE_CNT;
+
+      if (live[slot] != NULL)
+        palloc_free_multiple (live[slot], page_cnt);
+      live[slot] = palloc_get_multiple (PAL_USER, page_cnt);
+      if (live[slot] == NULL)
+        fail ("out of pages in thread %d", id);
+      pages += page_cnt;
+    }
+
+  for (i = 0; i < LIVE_CNT; i++)
+    if (live[i] != NULL)
+      palloc_free_multiple (live[i], page_cnt);
+  return pages;
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+fail "No CPU count reported.\n"
+  if !grep (/^\(bench-palloc\) CPUs online: \d+$/, @output);
+for my $cnt (1, 2, 3, 4) {
+    fail "No result for $cnt threads.\n"
+      if !grep (/^\(bench-palloc\) $cnt threads: \d+ pages\/s cached, \d+ pages\/s uncached$/, @output);
+}
+pass;
@@ -0,0 +1,122 @@
+/* Measures reader throughput of a reader-writer lock.
+
+   Runs 1, 2 and 4 readers next to a single writer for a fixed
+   time and reports how many read-side critical sections the
+   readers completed per timer tick.  Readers only share the
+   lock, so with enough CPUs online the read rate should grow
+   with the reader count even though a writer keeps taking the
+   lock exclusively.  Every reader also checks that it never sees
+   a half-finished write. */
+
+#include <stdio.h>
+#include "tests/threads/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+
+/* Largest number of readers in one round. */
+#define MAX_READERS 4
+
+/* Number of words the writer updates together. */
+#define DATA_CNT 16
+
+/* State shared by the readers and the writer of one round. */
+struct rw_bench
+  {
+    struct rwlock rwlock;       /* Lock under test. */
+    int data[DATA_CNT];         /* Protected by RWLOCK. */
+    int reader_cnt;             /* Workers below this index read. */
+    int64_t writes;             /* Writes completed. */
+    int torn;                   /* Reads that saw a partial write. */
+  };
+
+static bench_func rw_worker;
+static int64_t reader_loop (struct rw_bench *);
+static void writer_loop (struct rw_bench *);
+
+void
+test_bench_rwlock (void) 
+{
+  static struct rw_bench bench;
+  int cnt, i;
+
+  bench_begin ();
+  for (cnt = 1; cnt <= MAX_READERS; cnt *= 2) 
+    {
+      int64_t reads;
+
+      rwlock_init (&bench.rwlock);
+      for (i = 0; i < DATA_CNT; i++)
+        bench.data[i] = 0;
+      bench.reader_cnt = cnt;
+      bench.writes = 0;
+      bench.torn = 0;
+
+      /* The last worker of the round is the writer. */
+      reads = bench_round ("rw", cnt + 1, rw_worker, &bench);
+
+      if (bench.torn > 0)
+        fail ("%d readers saw a partial write", bench.torn);
+      if (bench.writes == 0)
+        fail ("writer starved with %d readers", cnt);
+
+      msg ("%d readers: %lld reads/tick, writer got in", cnt,
+           reads / BENCH_ROUND_TICKS);
+    }
+}
+
+static int64_t
+rw_worker (int id, void *bench_) 
+{
+  struct rw_bench *bench = bench_;
+
+  if (id < bench->reader_cnt)
+    return reader_loop (bench);
+  writer_loop (bench);
+  return 0;
+}
+
+static int64_t
+reader_loop (struct rw_bench *bench) 
+{
+  int64_t reads = 0;
+
+  while (!bench_stopped ()) 
+    {
+      int first, i;
+
+      rwlock_acquire_read (&bench->rwlock);
+      first = bench->data[0];
+      for (i = 1; i < DATA_CNT; i++)
+        if (bench->data[i] != first)
+          break;
+      rwlock_release_read (&bench->rwlock);
+
+      if (i != DATA_CNT)
+        __atomic_add_fetch (&bench->torn, 1, __ATOMIC_RELAXED);
+      reads++;
+    }
+
+  return reads;
+}
+
+/* Updates every word once per tick, so that readers mostly find
+   the lock free but still have to step aside regularly. */
+static void
+writer_loop (struct rw_bench *bench) 
+{
+  int value = 0;
+
+  while (!bench_stopped ()) 
+    {
+      int i;
+
+      rwlock_acquire_write (&bench->rwlock);
+      value++;
+      for (i = 0; i < DATA_CNT; i++)
+        bench->data[i] = value;
+      rwlock_release_write (&bench->rwlock);
+      bench->writes++;
+
+      timer_sleep (1);
+    }
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+fail "No CPU count reported.\n"
+  if !grep (/^\(bench-rwlock\) CPUs online: \d+$/, @output);
+for my $cnt (1, 2, 4) {
+    fail "No result for $cnt readers.\n"
+      if !grep (/^\(bench-rwlock\) $cnt readers: \d+ reads\/tick, writer got in$/, @output);
+}
+pass;
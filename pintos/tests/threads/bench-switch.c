@@ -0,0 +1,111 @@
+/* Measures context switches per second with 10, 100 and 1000
+   threads sitting in the ready queue.
+
+   Every worker runs at the same priority and does nothing but
+   call thread_yield(), so the run queue always holds all the
+   other workers and each yield is exactly one pass through
+   next_thread_to_run() plus a context switch. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of timer ticks to run each configuration for. */
+#define BENCH_TICKS (TIMER_FREQ * 2)
+
+/* Information shared by all the workers of one run. */
+struct switch_bench
+  {
+    int64_t deadline;           /* Tick at which workers stop. */
+    struct semaphore done;      /* Upped once per exiting worker. */
+  };
+
+/* Information about an individual worker. */
+struct switch_worker
+  {
+    struct switch_bench *bench; /* Shared run information. */
+    int64_t yields;             /* Number of yields performed. */
+  };
+
+static thread_func yield_worker;
+static void run_bench (int thread_cnt);
+
+void
+test_bench_switch (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  run_bench (10);
+  run_bench (100);
+  run_bench (1000);
+}
+
+/* Runs THREAD_CNT yielding workers for BENCH_TICKS ticks and
+   reports the resulting switch rate. */
+static void
+run_bench (int thread_cnt) 
+{
+  struct switch_bench bench;
+  struct switch_worker *workers;
+  int64_t start, elapsed, yields;
+  int i;
+
+  workers = malloc (sizeof *workers * thread_cnt);
+  if (workers == NULL)
+    fail ("couldn't allocate memory for %d workers", thread_cnt);
+  sema_init (&bench.done, 0);
+
+  /* Create all the workers before any of them gets to run. */
+  thread_set_priority (PRI_DEFAULT + 1);
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      char name[16];
+
+      snprintf (name, sizeof name, "y%d", i);
+      workers[i].bench = &bench;
+      workers[i].yields = 0;
+      if (thread_create (name, PRI_DEFAULT, yield_worker, &workers[i])
+          == TID_ERROR)
+        fail ("couldn't create worker %d", i);
+    }
+  start = timer_ticks ();
+  bench.deadline = start + BENCH_TICKS;
+
+  /* Let the workers run, then wait for all of them to finish. */
+  thread_set_priority (PRI_DEFAULT);
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&bench.done);
+  elapsed = timer_elapsed (start);
+
+  yields = 0;
+  for (i = 0; i < thread_cnt; i++)
+    yields += workers[i].yields;
+  free (workers);
+
+  if (elapsed <= 0)
+    elapsed = 1;
+  msg ("%d ready threads: %lld switches in %lld ticks, %lld switches/s.",
+       thread_cnt, yields, elapsed, yields * TIMER_FREQ / elapsed);
+}
+
+static void
+yield_worker (void *worker_) 
+{
+  struct switch_worker *worker = worker_;
+  struct switch_bench *bench = worker->bench;
+
+  while (timer_ticks () < bench->deadline) 
+    {
+      thread_yield ();
+      worker->yields++;
+    }
+  sema_up (&bench->done);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+for my $cnt (10, 100, 1000) {
+    fail "No result for $cnt ready threads.\n"
+      if !grep (/^\(bench-switch\) $cnt ready threads: \d+ switches in \d+ ticks, \d+ switches\/s\.$/, @output);
+}
+pass;
@@ -0,0 +1,93 @@
+/* Round runner shared by the throughput benchmarks.
+
+   A round starts a number of worker threads, lets them run for
+   BENCH_ROUND_TICKS timer ticks, tells them to stop, and adds up
+   the operations they report.  The main thread sleeps during the
+   round so that its CPU can run a worker too. */
+
+#include "tests/threads/bench.h"
+#include <debug.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* A worker of the current round. */
+struct bench_worker
+  {
+    int id;                     /* Index in the round. */
+    bench_func *func;           /* Benchmark body. */
+    void *aux;                  /* Argument for FUNC. */
+    int64_t ops;                /* Operations FUNC reported. */
+  };
+
+static struct bench_worker workers[BENCH_MAX_WORKERS];
+static struct semaphore done;   /* Upped once per finished worker. */
+static volatile bool stop;      /* Set when the round is over. */
+
+static thread_func worker_thread;
+
+/* Reports the number of CPUs the rounds can spread over. */
+void
+bench_begin (void) 
+{
+  /* The benchmarks do not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("CPUs online: %d", cpu_cnt);
+}
+
+/* Runs WORKER_CNT threads named NAME0, NAME1, ... that each call
+   FUNC with their index and AUX, for BENCH_ROUND_TICKS timer
+   ticks.  Returns the total number of operations they completed. */
+int64_t
+bench_round (const char *name, int worker_cnt, bench_func *func, void *aux) 
+{
+  int64_t ops = 0;
+  int i;
+
+  ASSERT (worker_cnt <= BENCH_MAX_WORKERS);
+
+  stop = false;
+  sema_init (&done, 0);
+  for (i = 0; i < worker_cnt; i++) 
+    {
+      char thread_name[16];
+
+      workers[i].id = i;
+      workers[i].func = func;
+      workers[i].aux = aux;
+      workers[i].ops = 0;
+      snprintf (thread_name, sizeof thread_name, "%s%d", name, i);
+      if (thread_create (thread_name, PRI_DEFAULT, worker_thread, &workers[i])
+          == TID_ERROR)
+        fail ("couldn't create thread %s", thread_name);
+    }
+
+  timer_sleep (BENCH_ROUND_TICKS);
+  stop = true;
+  for (i = 0; i < worker_cnt; i++)
+    sema_down (&done);
+
+  for (i = 0; i < worker_cnt; i++)
+    ops += workers[i].ops;
+  return ops;
+}
+
+/* Returns true once the current round is over. */
+bool
+bench_stopped (void) 
+{
+  return stop;
+}
+
+static void
+worker_thread (void *worker_) 
+{
+  struct bench_worker *worker = worker_;
+
+  worker->ops = worker->func (worker->id, worker->aux);
+  sema_up (&done);
+}
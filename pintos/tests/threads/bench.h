@@ -0,0 +1,26 @@
+#ifndef TESTS_THREADS_BENCH_H
+#define TESTS_THREADS_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/timer.h"
+
+/* Largest number of workers in one round: four threads under test
+   and one helper. */
+#define BENCH_MAX_WORKERS 5
+
+/* Length of each round in timer ticks. */
+#define BENCH_ROUND_TICKS (TIMER_FREQ / 2)
+
+/* Body of a benchmark worker.  ID is the worker's index in its
+   round and AUX is the argument passed to bench_round().  Runs
+   until bench_stopped() returns true and returns the number of
+   operations it completed. */
+typedef int64_t bench_func (int id, void *aux);
+
+void bench_begin (void);
+int64_t bench_round (const char *name, int worker_cnt,
+                     bench_func *, void *aux);
+bool bench_stopped (void);
+
+#endif /* tests/threads/bench.h */
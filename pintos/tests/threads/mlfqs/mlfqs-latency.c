@@ -0,0 +1,117 @@
+/* Measures wakeup-to-run latency of an interactive thread while
+   CPU-bound threads compete for the processor.
+
+   SPINNER_CNT threads spin for the whole test.  The main thread
+   repeatedly sleeps for a short random number of ticks and, on
+   each return from timer_sleep(), records how many ticks past
+   its wakeup time it actually got to run.  Under the MLFQS the
+   sleeper's recent_cpu stays low, so it should outrank the
+   spinners and run as soon as it wakes.
+
+   Reports the 50th, 90th and 99th percentile and the maximum
+   latency, in timer ticks. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SPINNER_CNT 8           /* Number of CPU-bound threads. */
+#define SAMPLE_CNT 500          /* Number of wakeups to measure. */
+#define MAX_SLEEP 5             /* Longest sleep, in ticks. */
+
+/* Information shared with the spinners. */
+struct latency_test
+  {
+    volatile bool stop;         /* Set when the spinners should exit. */
+    struct semaphore done;      /* Upped once per exiting spinner. */
+  };
+
+static thread_func spinner;
+static int64_t percentile (const int64_t *sorted, int cnt, int pct);
+
+void
+test_mlfqs_latency (void) 
+{
+  struct latency_test test;
+  int64_t *samples;
+  int64_t total;
+  int i;
+
+  ASSERT (thread_mlfqs);
+
+  samples = malloc (sizeof *samples * SAMPLE_CNT);
+  if (samples == NULL)
+    fail ("couldn't allocate memory for samples");
+
+  msg ("Starting %d CPU-bound threads.", SPINNER_CNT);
+  test.stop = false;
+  sema_init (&test.done, 0);
+  for (i = 0; i < SPINNER_CNT; i++) 
+    {
+      char name[16];
+
+      snprintf (name, sizeof name, "spin %d", i);
+      thread_create (name, PRI_DEFAULT, spinner, &test);
+    }
+
+  /* Give the spinners time to build up recent_cpu. */
+  timer_sleep (2 * TIMER_FREQ);
+
+  msg ("Sleeping and waking %d times.", SAMPLE_CNT);
+  total = 0;
+  for (i = 0; i < SAMPLE_CNT; i++) 
+    {
+      int64_t ticks = random_ulong () % MAX_SLEEP + 1;
+      int64_t wakeup = timer_ticks () + ticks;
+      int j;
+
+      timer_sleep (ticks);
+
+      /* Insert the sample in sorted order. */
+      samples[i] = timer_ticks () - wakeup;
+      total += samples[i];
+      for (j = i; j > 0 && samples[j - 1] > samples[j]; j--) 
+        {
+          int64_t tmp = samples[j - 1];
+          samples[j - 1] = samples[j];
+          samples[j] = tmp;
+        }
+    }
+
+  test.stop = true;
+  for (i = 0; i < SPINNER_CNT; i++)
+    sema_down (&test.done);
+
+  msg ("Wakeup-to-run latency in ticks: mean %lld.%02lld, "
+       "p50 %lld, p90 %lld, p99 %lld, max %lld.",
+       total / SAMPLE_CNT, total * 100 / SAMPLE_CNT % 100,
+       percentile (samples, SAMPLE_CNT, 50),
+       percentile (samples, SAMPLE_CNT, 90),
+       percentile (samples, SAMPLE_CNT, 99),
+       samples[SAMPLE_CNT - 1]);
+  free (samples);
+}
+
+/* Returns the PCT-th percentile of the CNT values in SORTED. */
+static int64_t
+percentile (const int64_t *sorted, int cnt, int pct) 
+{
+  int idx = (cnt * pct + 99) / 100 - 1;
+
+  return sorted[idx < 0 ? 0 : idx];
+}
+
+static void
+spinner (void *test_) 
+{
+  struct latency_test *test = test_;
+
+  while (!test->stop)
+    continue;
+  sema_up (&test->done);
+}
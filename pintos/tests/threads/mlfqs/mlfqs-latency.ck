@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+fail "No latency percentiles in output.\n"
+  if !grep (/^\(mlfqs-latency\) Wakeup-to-run latency in ticks: mean \d+\.\d+, p50 \d+, p90 \d+, p99 \d+, max \d+\.$/, @output);
+pass;
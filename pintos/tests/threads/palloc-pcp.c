@@ -0,0 +1,149 @@
+/* Checks the per-CPU page caches in front of the palloc pools.
+
+   A page freed on a CPU must be the next page that CPU hands out,
+   since it is still hot in that CPU's cache.
+
+   Then allocates user pages until the pool runs dry, twice: once
+   as is, and once after a thread on every CPU has left a batch of
+   free pages in its CPU's cache.  Running dry has to take those
+   pages back, so both runs must get the same number of pages.
+   Every page is tagged with its sequence number, which is checked
+   before it is freed, to catch a page handed out twice. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Head of each page we hold, chaining them together. */
+struct held_page
+  {
+    struct held_page *next;
+    size_t seq;
+  };
+
+static struct semaphore filled;
+
+static size_t exhaust (struct held_page **);
+static void release (struct held_page *, size_t cnt);
+static thread_func fill_thread;
+
+void
+test_palloc_pcp (void)
+{
+  struct held_page *pages;
+  struct cpu *cpu;
+  enum intr_level old_level;
+  size_t first, second;
+  void *p, *q;
+  int i;
+
+  /* Stay on one CPU so that we always use the same cache. */
+  old_level = intr_disable ();
+  cpu = this_cpu ();
+  intr_set_level (old_level);
+  thread_bind_cpu (cpu);
+
+  p = palloc_get_page (PAL_USER);
+  if (p == NULL)
+    fail ("no user pages");
+  palloc_free_page (p);
+  q = palloc_get_page (PAL_USER);
+  if (q != p)
+    fail ("freed page %p came back as %p", p, q);
+  palloc_free_page (q);
+  msg ("Freed page is handed out again on the same CPU.");
+
+  first = exhaust (&pages);
+  release (pages, first);
+  msg ("Exhausted the user pool.");
+
+  /* Leave free pages in the cache of every CPU. */
+  sema_init (&filled, 0);
+  for (i = 0; i < cpu_cnt; i++)
+    if (&cpus[i] != cpu
+        && thread_create ("fill", PRI_DEFAULT, fill_thread, &cpus[i])
+           == TID_ERROR)
+      fail ("couldn't create thread for CPU %d", i);
+  fill_thread (NULL);
+  for (i = 0; i < cpu_cnt; i++)
+    sema_down (&filled);
+  msg ("Filled the page cache of every CPU.");
+
+  second = exhaust (&pages);
+  release (pages, second);
+  if (second != first)
+    fail ("got %zu pages the first time but %zu the second", first, second);
+  msg ("Exhausted the user pool again with the same page count.");
+
+  thread_bind_cpu (NULL);
+}
+
+/* Allocates user pages until none are left, chaining them into
+   *PAGES, and returns how many it got. */
+static size_t
+exhaust (struct held_page **pages)
+{
+  size_t cnt = 0;
+  int misses = 0;
+
+  *pages = NULL;
+  while (misses < 2)
+    {
+      /* Pages zeroed by an idle CPU while the pool drained are
+         only handed out with PAL_ZERO. */
+      struct held_page *p = palloc_get_page (PAL_USER);
+      if (p == NULL)
+        p = palloc_get_page (PAL_USER | PAL_ZERO);
+
+      if (p != NULL)
+        {
+          p->next = *pages;
+          p->seq = cnt++;
+          *pages = p;
+          misses = 0;
+        }
+      else if (++misses < 2)
+        {
+          /* An idle CPU may be zeroing a page it took just before
+             the pool ran dry.  Give it time to finish. */
+          timer_sleep (1);
+        }
+    }
+
+  if (cnt == 0)
+    fail ("no user pages");
+  return cnt;
+}
+
+/* Checks the tags of the CNT PAGES from exhaust(), which come
+   last page first, and frees them. */
+static void
+release (struct held_page *pages, size_t cnt)
+{
+  while (pages != NULL)
+    {
+      struct held_page *next = pages->next;
+
+      if (cnt == 0 || pages->seq != --cnt)
+        fail ("page %p was handed out twice", pages);
+      palloc_free_page (pages);
+      pages = next;
+    }
+}
+
+/* Leaves a batch of free pages in the cache of CPU_, or of the
+   current CPU if CPU_ is null. */
+static void
+fill_thread (void *cpu_)
+{
+  if (cpu_ != NULL)
+    thread_bind_cpu (cpu_);
+  palloc_free_page (palloc_get_page (PAL_USER | PAL_ASSERT));
+  sema_up (&filled);
+}
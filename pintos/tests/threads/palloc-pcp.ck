@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-pcp) begin
+(palloc-pcp) Freed page is handed out again on the same CPU.
+(palloc-pcp) Exhausted the user pool.
+(palloc-pcp) Filled the page cache of every CPU.
+(palloc-pcp) Exhausted the user pool again with the same page count.
+(palloc-pcp) end
+EOF
+pass;
@@ -0,0 +1,79 @@
+/* The main thread and a "reader" thread hold a reader-writer
+   lock for reading.  A higher-priority "writer" thread then
+   waits for the readers to drain, donating its priority to the
+   main thread.  When the main thread stops reading, the donation
+   must pass to the reader, so that the reader finishes and lets
+   the writer in before a medium-priority thread gets to run. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct rwlock_test
+  {
+    struct rwlock rwlock;
+    struct semaphore release;
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+static thread_func medium_thread_func;
+
+void
+test_priority_donate_rwlock (void) 
+{
+  struct rwlock_test t;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&t.rwlock);
+  sema_init (&t.release, 0);
+
+  rwlock_acquire_read (&t.rwlock);
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &t);
+  thread_create ("writer", PRI_DEFAULT + 3, writer_thread_func, &t);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 3, thread_get_priority ());
+  thread_create ("medium", PRI_DEFAULT + 2, medium_thread_func, NULL);
+
+  sema_up (&t.release);
+  rwlock_release_read (&t.rwlock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+reader_thread_func (void *t_) 
+{
+  struct rwlock_test *t = t_;
+
+  rwlock_acquire_read (&t->rwlock);
+  msg ("reader: got the lock");
+  sema_down (&t->release);
+  msg ("reader: priority %d", thread_get_priority ());
+  rwlock_release_read (&t->rwlock);
+  msg ("reader: done");
+}
+
+static void
+writer_thread_func (void *t_) 
+{
+  struct rwlock_test *t = t_;
+
+  rwlock_acquire_write (&t->rwlock);
+  msg ("writer: got the lock");
+  rwlock_release_write (&t->rwlock);
+  msg ("writer: done");
+}
+
+static void
+medium_thread_func (void *aux UNUSED) 
+{
+  msg ("medium: done");
+}
@@ -0,0 +1,101 @@
+/* Checks the real-time and idle scheduling classes.
+
+   Fills the CPU with normal threads that never block, then moves
+   the main thread into SCHED_FIFO at the lowest priority and
+   sleeps for a single tick over and over.  Each time it wakes up
+   it must run again within a tick, ahead of every normal thread,
+   because the class is compared before the priority.
+
+   A SCHED_IDLE thread that is ready the whole time must not run
+   until every normal thread is gone, even though it asked for
+   the highest priority.  That only holds with a single CPU, since
+   a CPU with no normal thread of its own may rightly run it, so
+   Make.tests runs this test with --smp 1 and the test checks it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of normal threads keeping the CPU busy. */
+#define BATCH_CNT 8
+
+/* Number of times the FIFO thread sleeps and wakes up. */
+#define WAKEUP_CNT 10
+
+static volatile bool batch_done;        /* Tells the batch threads to exit. */
+static int batch_running;               /* Batch threads not yet exited. */
+static struct semaphore done;           /* Upped by each finished thread. */
+
+static thread_func batch_thread;
+static thread_func idle_class_thread;
+
+void
+test_sched_rt (void) 
+{
+  int on_time = 0;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Nor with more than one CPU; see above. */
+  if (cpu_cnt > 1)
+    fail ("needs a single CPU, %d are online", cpu_cnt);
+
+  sema_init (&done, 0);
+
+  /* Runs right away because of its priority, then drops itself
+     into SCHED_IDLE. */
+  thread_create ("idle-class", PRI_MAX, idle_class_thread, NULL);
+
+  batch_running = BATCH_CNT;
+  for (i = 0; i < BATCH_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "batch %d", i);
+      thread_create (name, PRI_DEFAULT, batch_thread, NULL);
+    }
+
+  ASSERT (thread_set_class (SCHED_FIFO, PRI_MIN));
+  msg ("Main thread is SCHED_FIFO at PRI_MIN.");
+
+  /* Sleeping for one tick ends at the next tick or, if a tick
+     goes by before timer_sleep() reads the clock, the one after.
+     Anything later means a normal thread ran first. */
+  for (i = 0; i < WAKEUP_CNT; i++) 
+    {
+      int64_t start = timer_ticks ();
+      timer_sleep (1);
+      if (timer_ticks () - start <= 2)
+        on_time++;
+    }
+  msg ("Woke up within a tick %d times out of %d.", on_time, WAKEUP_CNT);
+
+  batch_done = true;
+  for (i = 0; i < BATCH_CNT + 1; i++)
+    sema_down (&done);
+
+  ASSERT (thread_set_class (SCHED_NORMAL, PRI_DEFAULT));
+}
+
+static void
+batch_thread (void *aux UNUSED) 
+{
+  while (!batch_done)
+    barrier ();
+  __atomic_sub_fetch (&batch_running, 1, __ATOMIC_SEQ_CST);
+  sema_up (&done);
+}
+
+static void
+idle_class_thread (void *aux UNUSED) 
+{
+  ASSERT (thread_set_class (SCHED_IDLE, PRI_MAX));
+  msg ("SCHED_IDLE thread ran with %d batch threads left.",
+       __atomic_load_n (&batch_running, __ATOMIC_SEQ_CST));
+  sema_up (&done);
+}
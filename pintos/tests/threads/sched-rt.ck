@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-rt) begin
+(sched-rt) Main thread is SCHED_FIFO at PRI_MIN.
+(sched-rt) Woke up within a tick 10 times out of 10.
+(sched-rt) SCHED_IDLE thread ran with 0 batch threads left.
+(sched-rt) end
+EOF
+pass;
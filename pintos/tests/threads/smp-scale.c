@@ -0,0 +1,129 @@
+/* Measures how CPU-bound work scales across processors.
+
+   Runs 1, 2 and 4 workers that each perform the same fixed
+   amount of computation and reports how long each batch took.
+   With enough CPUs online, every worker should land on its own
+   processor, so the batch of N workers should take about as long
+   as the single worker and the reported speedup should approach
+   N.  On a uniprocessor the workers simply share one CPU and the
+   speedup stays near 1. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Largest number of workers in one batch. */
+#define MAX_WORKERS 4
+
+/* Timer ticks of computation each worker performs when it has a
+   CPU to itself. */
+#define WORK_TICKS (TIMER_FREQ / 2)
+
+/* Information shared by all the workers of one batch. */
+struct scale_bench
+  {
+    int64_t loops;              /* Iterations each worker performs. */
+    struct semaphore done;      /* Upped once per finished worker. */
+  };
+
+static thread_func scale_worker;
+static int64_t calibrate (void);
+static int64_t run_batch (struct scale_bench *, int worker_cnt);
+static void spin (int64_t loops);
+
+void
+test_smp_scale (void) 
+{
+  struct scale_bench bench;
+  int64_t base;
+  int cnt;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("CPUs online: %d", cpu_cnt);
+
+  bench.loops = calibrate ();
+  sema_init (&bench.done, 0);
+
+  base = run_batch (&bench, 1);
+  for (cnt = 1; cnt <= MAX_WORKERS; cnt *= 2) 
+    {
+      int64_t elapsed = cnt == 1 ? base : run_batch (&bench, cnt);
+      int64_t speedup = cnt * base * 100 / elapsed;
+
+      msg ("%d workers: %lld ticks, speedup %lld.%02lld",
+           cnt, elapsed, speedup / 100, speedup % 100);
+    }
+}
+
+/* Returns the number of spin() iterations that take about
+   WORK_TICKS timer ticks on this CPU. */
+static int64_t
+calibrate (void) 
+{
+  int64_t loops = 1024;
+
+  for (;;) 
+    {
+      int64_t start = timer_ticks ();
+
+      while (timer_ticks () == start)
+        continue;
+      start = timer_ticks ();
+      spin (loops);
+      if (timer_elapsed (start) >= WORK_TICKS / 8)
+        return loops * WORK_TICKS / timer_elapsed (start);
+      loops *= 2;
+    }
+}
+
+/* Runs WORKER_CNT workers at once and returns the number of
+   ticks until the last of them finished. */
+static int64_t
+run_batch (struct scale_bench *bench, int worker_cnt) 
+{
+  int64_t start, elapsed;
+  int i;
+
+  start = timer_ticks ();
+  for (i = 0; i < worker_cnt; i++) 
+    {
+      char name[16];
+
+      snprintf (name, sizeof name, "scale%d", i);
+      if (thread_create (name, PRI_DEFAULT, scale_worker, bench)
+          == TID_ERROR)
+        fail ("couldn't create worker %d", i);
+    }
+
+  /* Block so that this CPU can run a worker too. */
+  for (i = 0; i < worker_cnt; i++)
+    sema_down (&bench->done);
+  elapsed = timer_elapsed (start);
+
+  return elapsed > 0 ? elapsed : 1;
+}
+
+static void
+scale_worker (void *bench_) 
+{
+  struct scale_bench *bench = bench_;
+
+  spin (bench->loops);
+  sema_up (&bench->done);
+}
+
+/* Burns LOOPS iterations of pure computation. */
+static void
+spin (int64_t loops) 
+{
+  volatile uint64_t x = 0;
+
+  while (loops-- > 0)
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+fail "No CPU count reported.\n"
+  if !grep (/^\(smp-scale\) CPUs online: \d+$/, @output);
+for my $cnt (1, 2, 4) {
+    fail "No result for $cnt workers.\n"
+      if !grep (/^\(smp-scale\) $cnt workers: \d+ ticks, speedup \d+\.\d\d$/, @output);
+}
+pass;
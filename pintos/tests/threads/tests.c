@@ -25,6 +25,7 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-rwlock", test_priority_donate_rwlock},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
@@ -38,6 +39,14 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"mlfqs-latency", test_mlfqs_latency},
+    {"bench-switch", test_bench_switch},
+    {"smp-scale", test_smp_scale},
+    {"bench-rwlock", test_bench_rwlock},
+    {"sched-rt", test_sched_rt},
+    {"bench-malloc", test_bench_malloc},
+    {"palloc-pcp", test_palloc_pcp},
+    {"bench-palloc", test_bench_palloc},
   };
 
 static const char *test_name;
@@ -19,6 +19,7 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_rwlock;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
@@ -32,6 +33,14 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_mlfqs_latency;
+extern test_func test_bench_switch;
+extern test_func test_smp_scale;
+extern test_func test_bench_rwlock;
+extern test_func test_sched_rt;
+extern test_func test_bench_malloc;
+extern test_func test_palloc_pcp;
+extern test_func test_bench_palloc;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,49 @@
+/* Starts several threads with clone() that each add up one part
+   of a shared array and store the result in shared memory, then
+   joins them with wait().  The threads share the address space,
+   so the parent sees what they wrote. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define PART_SIZE 256
+
+static int values[THREAD_CNT * PART_SIZE];
+static int sums[THREAD_CNT];
+
+static void
+add_part (void *aux)
+{
+  int *sum_slot = aux;
+  int part = sum_slot - sums;
+  int sum = 0;
+  int i;
+
+  for (i = 0; i < PART_SIZE; i++)
+    sum += values[part * PART_SIZE + i];
+  *sum_slot = sum;
+}
+
+void
+test_main (void) 
+{
+  pid_t tids[THREAD_CNT];
+  int total = 0;
+  int i;
+
+  for (i = 0; i < THREAD_CNT * PART_SIZE; i++)
+    values[i] = i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = clone (add_part, &sums[i])) != PID_ERROR,
+           "clone thread %d", i);
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (wait (tids[i]) == 0, "wait for thread %d", i);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    total += sums[i];
+  CHECK (total == THREAD_CNT * PART_SIZE * (THREAD_CNT * PART_SIZE - 1) / 2,
+         "sum of all parts is %d", total);
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clone-join) begin
+(clone-join) clone thread 0
+(clone-join) clone thread 1
+(clone-join) clone thread 2
+(clone-join) clone thread 3
+(clone-join) wait for thread 0
+(clone-join) wait for thread 1
+(clone-join) wait for thread 2
+(clone-join) wait for thread 3
+(clone-join) sum of all parts is 523776
+(clone-join) end
+clone-join: exit(0)
+EOF
+pass;
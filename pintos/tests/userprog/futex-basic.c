@@ -0,0 +1,21 @@
+/* Checks the futex system calls from a single thread.  Waiting
+   on a word that no longer holds the expected value must return
+   -1 at once instead of sleeping, waking a word that nobody waits
+   on must wake no one, and a word that is not aligned must be
+   rejected. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word[2];
+
+void
+test_main (void) 
+{
+  word[0] = 1;
+  CHECK (futex_wait (&word[0], 0) == -1, "futex_wait on a changed word");
+  CHECK (futex_wake (&word[0], 1) == 0, "futex_wake with no waiters");
+  CHECK (futex_wait ((int *) ((char *) word + 1), 0) == -1,
+         "futex_wait on an unaligned word");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-basic) begin
+(futex-basic) futex_wait on a changed word
+(futex-basic) futex_wake with no waiters
+(futex-basic) futex_wait on an unaligned word
+(futex-basic) end
+futex-basic: exit(0)
+EOF
+pass;
@@ -0,0 +1,52 @@
+/* A producer and a consumer thread created with clone() pass
+   numbers through a one-slot buffer, sleeping on futexes while
+   the slot is full or empty.  Every number must arrive exactly
+   once and in order. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITEM_CNT 500
+
+static volatile int full;
+static volatile int slot;
+static volatile int received;
+static volatile int in_order = 1;
+
+static void
+consume (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 1; i <= ITEM_CNT; i++)
+    {
+      while (!full)
+        futex_wait ((int *) &full, 0);
+      if (slot != i)
+        in_order = 0;
+      received++;
+      full = 0;
+      futex_wake ((int *) &full, 1);
+    }
+}
+
+void
+test_main (void) 
+{
+  pid_t consumer;
+  int i;
+
+  CHECK ((consumer = clone (consume, NULL)) != PID_ERROR, "clone consumer");
+  for (i = 1; i <= ITEM_CNT; i++)
+    {
+      while (full)
+        futex_wait ((int *) &full, 1);
+      slot = i;
+      full = 1;
+      futex_wake ((int *) &full, 1);
+    }
+  CHECK (wait (consumer) == 0, "wait for consumer");
+  CHECK (received == ITEM_CNT, "consumer received %d items", received);
+  CHECK (in_order, "items arrived in order");
+}
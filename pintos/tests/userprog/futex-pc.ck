@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-pc) begin
+(futex-pc) clone consumer
+(futex-pc) wait for consumer
+(futex-pc) consumer received 500 items
+(futex-pc) items arrived in order
+(futex-pc) end
+futex-pc: exit(0)
+EOF
+pass;
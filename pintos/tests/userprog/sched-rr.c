@@ -0,0 +1,47 @@
+/* A thread created with clone() keeps the CPU busy as a normal
+   thread while the main thread, which entered SCHED_RR right
+   after creating it, sleeps on a futex.  When the busy thread wakes the main thread, the
+   main thread must preempt it at once, before the busy thread
+   gets back to its loop.  Needs a single CPU and the kernel
+   option -user-rt. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Iterations the busy thread spins before it wakes the main
+   thread, long enough to cover several time slices. */
+#define SPIN_CNT 50000000
+
+static volatile int woken;
+static volatile int done;
+static volatile long long progress;
+static volatile long long woken_at;
+
+static void
+hog (void *aux UNUSED)
+{
+  while (progress < SPIN_CNT)
+    progress++;
+
+  woken_at = progress;
+  woken = 1;
+  futex_wake ((int *) &woken, 1);
+
+  while (!done)
+    progress++;
+}
+
+void
+test_main (void) 
+{
+  pid_t tid;
+
+  CHECK ((tid = clone (hog, NULL)) != PID_ERROR, "clone CPU hog");
+  CHECK (sched_setclass (SCHED_RR, 0) == 0, "enter SCHED_RR");
+  while (!woken)
+    futex_wait ((int *) &woken, 0);
+  CHECK (progress == woken_at, "preempted the CPU hog");
+  done = 1;
+  CHECK (wait (tid) == 0, "wait for CPU hog");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-rr) begin
+(sched-rr) clone CPU hog
+(sched-rr) enter SCHED_RR
+(sched-rr) preempted the CPU hog
+(sched-rr) wait for CPU hog
+(sched-rr) end
+sched-rr: exit(0)
+EOF
+pass;
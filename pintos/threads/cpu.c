@@ -0,0 +1,346 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/lapic.h"
+#include "devices/timer.h"
+#include "threads/fpu.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#include "userprog/syscall.h"
+#include "userprog/tss.h"
+#endif
+
+/* 대칭형 다중 처리(SMP).
+
+   BIOS가 남겨둔 MP 설정 테이블([MP] Intel MultiProcessor Specification
+   1.4)에서 CPU 목록과 Local APIC 주소를 읽고, BSP가 나머지 CPU(AP)를
+   INIT-STARTUP-STARTUP IPI 순서로 하나씩 깨움. 깨어난 AP는
+   threads/ap-start.S를 거쳐 ap_main()에 도착해서 GDT, IDT, TSS와
+   Local APIC를 설정한 뒤 자신의 idle 스레드가 되어 스케줄러에 참여함.
+
+   장치 인터럽트와 전역 tick은 지금처럼 BSP만 받고, AP는 Local APIC
+   타이머로 자신의 타임 슬라이스만 관리함. */
+
+struct cpu cpus[CPU_MAX];
+int cpu_cnt = 1;
+bool smp_started;
+
+/* ap-start.S와 공유. 한 번에 AP 하나만 깨우므로 전역 변수 하나로 충분 */
+extern char ap_trampoline[], ap_trampoline_end[];
+uint64_t ap_boot_cr3;                   /* AP가 사용할 페이지 테이블 (물리 주소). */
+uint64_t ap_boot_stack;                 /* AP의 첫 스택 꼭대기. */
+static struct cpu *ap_booting;          /* 지금 깨우고 있는 AP. */
+
+void ap_main (void) NO_RETURN;
+
+/* MP Floating Pointer Structure. [MP] 4.1 */
+struct mp_fps {
+	char signature[4];                  /* "_MP_" */
+	uint32_t config;                    /* MP 설정 테이블의 물리 주소. */
+	uint8_t length;                     /* 16바이트 단위 길이 (1). */
+	uint8_t spec_rev;
+	uint8_t checksum;                   /* 모든 바이트의 합이 0. */
+	uint8_t type;                       /* 0이 아니면 기본 설정 사용. */
+	uint8_t imcrp;
+	uint8_t reserved[3];
+} __attribute__ ((packed));
+
+/* MP Configuration Table Header. [MP] 4.2 */
+struct mp_config {
+	char signature[4];                  /* "PCMP" */
+	uint16_t length;                    /* 헤더를 포함한 기본 테이블 길이. */
+	uint8_t version;
+	uint8_t checksum;
+	char oem_id[8];
+	char product_id[12];
+	uint32_t oem_table;
+	uint16_t oem_table_size;
+	uint16_t entry_cnt;                 /* 헤더 뒤에 오는 항목 수. */
+	uint32_t lapic_addr;                /* Local APIC의 물리 주소. */
+	uint16_t ext_length;
+	uint8_t ext_checksum;
+	uint8_t reserved;
+} __attribute__ ((packed));
+
+/* Processor Entry. [MP] 4.3.1 */
+struct mp_proc {
+	uint8_t type;                       /* MP_PROC */
+	uint8_t lapic_id;
+	uint8_t lapic_version;
+	uint8_t flags;
+	uint32_t signature;
+	uint32_t features;
+	uint8_t reserved[8];
+} __attribute__ ((packed));
+
+#define MP_PROC 0                       /* 프로세서 항목 종류. */
+#define MP_PROC_ENABLED 0x01            /* 사용 가능한 프로세서. */
+#define MP_PROC_BSP 0x02                /* 부팅 프로세서. */
+#define MP_ENTRY_LEN 8                  /* 프로세서가 아닌 항목의 길이. */
+
+/* AP가 깨어나기를 기다리는 최대 시간 (밀리초). */
+#define AP_BOOT_TIMEOUT_MS 100
+
+static bool mp_checksum (const void *, size_t);
+static struct mp_fps *mp_search (uint64_t paddr, size_t len);
+static struct mp_config *mp_find_config (void);
+static bool ap_start (struct cpu *, uint8_t lapic_id);
+
+/* 현재 CPU의 상태를 반환. */
+/* 실행 중인 스레드가 다른 CPU로 옮겨갈 수 있으므로, 반환값을 계속 쓰려면 */
+/* 인터럽트를 끈 채로 호출해야 함 */
+struct cpu *
+this_cpu (void) {
+	/* AP를 깨우기 전에는 스레드 구조체가 준비되지 않았을 수도 있음 */
+	if (!smp_started)
+	{
+		return &cpus[0];
+	}
+
+	/* run_cpu는 그 CPU에서 전환되어 들어올 때만 바뀌므로, 스레드가 다른 */
+	/* CPU의 준비 큐로 옮겨지는 중이라도 지금 실제로 도는 CPU를 가리킴 */
+	return ((struct thread *) pg_round_down (rrsp ()))->run_cpu;
+}
+
+/* BSP의 CPU 상태를 초기화. thread_init()보다 먼저 호출 */
+void
+cpu_init (void) {
+	cpus[0].id = 0;
+	cpus[0].started = true;
+}
+
+/* MP 설정 테이블에서 AP를 찾아 모두 깨움. AP가 없다면 아무것도 하지 않음. */
+/* BSP에서 timer_calibrate() 뒤에 인터럽트를 켠 채로 호출 */
+void
+smp_init (void) {
+	struct mp_config *conf = mp_find_config ();
+	uint8_t bsp_id = 0;
+	int proc_cnt = 0;
+	uint8_t *p, *end;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	if (NULL == conf)
+	{
+		return;
+	}
+
+	/* 사용 가능한 프로세서가 하나뿐이라면 Local APIC도 건드리지 않음 */
+	p = (uint8_t *) (conf + 1);
+	end = (uint8_t *) conf + conf->length;
+	while (p < end)
+	{
+		struct mp_proc *proc = (struct mp_proc *) p;
+
+		if (MP_PROC != proc->type)
+		{
+			p += MP_ENTRY_LEN;
+			continue;
+		}
+
+		if (0 != (proc->flags & MP_PROC_ENABLED))
+		{
+			proc_cnt++;
+		}
+		if (0 != (proc->flags & MP_PROC_BSP))
+		{
+			bsp_id = proc->lapic_id;
+		}
+		p += sizeof *proc;
+	}
+
+	if (1 >= proc_cnt)
+	{
+		return;
+	}
+
+	intr_disable ();
+	lapic_map (conf->lapic_addr);
+	lapic_init (true);
+	cpus[0].lapic_id = lapic_id ();
+	intr_enable ();
+	ASSERT (cpus[0].lapic_id == bsp_id);
+
+	lapic_calibrate ();
+
+	memcpy (ptov (AP_TRAMPOLINE), ap_trampoline,
+			ap_trampoline_end - ap_trampoline);
+	ap_boot_cr3 = vtop (base_pml4);
+
+	/* 이제부터 this_cpu()는 실행 중인 스레드를 마지막으로 실행한 CPU를 반환. */
+	/* BSP의 스레드는 모두 thread_init()과 schedule()에서 cpus[0]으로 설정되어 있음 */
+	smp_started = true;
+
+	p = (uint8_t *) (conf + 1);
+	while ((p < end) && (CPU_MAX > cpu_cnt))
+	{
+		struct mp_proc *proc = (struct mp_proc *) p;
+
+		if (MP_PROC != proc->type)
+		{
+			p += MP_ENTRY_LEN;
+			continue;
+		}
+		p += sizeof *proc;
+
+		if ((0 == (proc->flags & MP_PROC_ENABLED)) || (bsp_id == proc->lapic_id))
+		{
+			continue;
+		}
+
+		if (ap_start (&cpus[cpu_cnt], proc->lapic_id))
+		{
+			/* AP가 준비를 모두 마친 뒤에야 스레드를 배정받도록 마지막에 셈 */
+			__atomic_store_n (&cpu_cnt, cpu_cnt + 1, __ATOMIC_RELEASE);
+		}
+		else
+		{
+			printf ("smp: CPU with APIC ID %d did not start\n", proc->lapic_id);
+		}
+	}
+
+	printf ("smp: %d CPUs online.\n", cpu_cnt);
+}
+
+/* C를 LAPIC_ID인 AP로 깨움. AP가 초기화를 마쳤다면 true */
+static bool
+ap_start (struct cpu *c, uint8_t lapic_id) {
+	void *stack = palloc_get_page (PAL_ZERO);
+
+	if (NULL == stack)
+	{
+		return false;
+	}
+
+	memset (c, 0, sizeof *c);
+	c->id = c - cpus;
+	c->lapic_id = lapic_id;
+	ap_booting = c;
+	ap_boot_stack = (uint64_t) stack + PGSIZE;
+
+	/* [MP] B.4 "Application Processor Startup"의 순서를 따름 */
+	lapic_send_init (lapic_id);
+	timer_msleep (10);
+	lapic_send_startup (lapic_id, AP_TRAMPOLINE);
+	timer_usleep (200);
+	lapic_send_startup (lapic_id, AP_TRAMPOLINE);
+
+	for (int ms = 0; (ms < AP_BOOT_TIMEOUT_MS) && !c->started; ms += 10)
+	{
+		timer_msleep (10);
+	}
+
+	if (!c->started)
+	{
+		/* 늦게라도 깨어나 스택을 쓰면 안 되므로 페이지는 돌려받지 않음 */
+		return false;
+	}
+
+	return true;
+}
+
+/* 다른 CPU C가 자신의 준비 큐를 다시 보도록 재스케줄 IPI를 보냄 */
+void
+cpu_kick (struct cpu *c) {
+	if ((c != this_cpu ()) && lapic_present ())
+	{
+		lapic_send_ipi (c->lapic_id, LAPIC_RESCHED_VEC);
+	}
+}
+
+/* ap-start.S에서 넘어온 AP의 C 진입점. */
+/* smp_init()이 준비해 둔 스택 페이지 위에서 실행되며, 이 페이지가 그대로 */
+/* 이 CPU의 idle 스레드가 됨 */
+void
+ap_main (void) {
+	struct cpu *c = ap_booting;
+
+	/* this_cpu()가 올바른 값을 돌려주도록 스레드 구조체부터 만듦 */
+	thread_init_ap (c);
+#ifdef USERPROG
+	tss_init_ap ();
+	gdt_init_ap ();
+	syscall_init_ap ();
+#endif
+	intr_init_ap ();
+	fpu_init_ap ();
+	lapic_init (false);
+	lapic_timer_start ();
+
+	/* BSP가 볼 수 있도록 앞의 모든 쓰기가 끝난 뒤에 알림 */
+	__atomic_store_n (&c->started, true, __ATOMIC_RELEASE);
+
+	thread_idle_ap ();
+}
+
+/* LEN 바이트의 합이 0이면 true */
+static bool
+mp_checksum (const void *p_, size_t len) {
+	const uint8_t *p = p_;
+	uint8_t sum = 0;
+
+	for (size_t i = 0; i < len; ++i)
+	{
+		sum += p[i];
+	}
+
+	return 0 == sum;
+}
+
+/* 물리 주소 PADDR부터 LEN 바이트 안에서 MP Floating Pointer를 찾음. */
+/* [MP] 4. 구조체는 16바이트 경계에 있음 */
+static struct mp_fps *
+mp_search (uint64_t paddr, size_t len) {
+	uint8_t *p = ptov (paddr);
+	uint8_t *end = p + len;
+
+	for (; p + sizeof (struct mp_fps) <= end; p += 16)
+	{
+		if ((0 == memcmp (p, "_MP_", 4)) && mp_checksum (p, sizeof (struct mp_fps)))
+		{
+			return (struct mp_fps *) p;
+		}
+	}
+
+	return NULL;
+}
+
+/* BIOS가 남긴 MP 설정 테이블을 찾아 반환. 없다면 NULL. */
+/* BIOS 데이터 영역(0x400)은 물리 페이지 0에 있는 main 스레드 구조체가 */
+/* 덮어썼으므로 EBDA 위치를 읽을 수 없음. 대신 EBDA가 보통 놓이는 */
+/* 640KB 기본 메모리의 마지막 1KB와 BIOS ROM 영역을 찾음 */
+static struct mp_config *
+mp_find_config (void) {
+	struct mp_fps *fps;
+	struct mp_config *conf;
+
+	fps = mp_search (0x9fc00, 1024);
+	if (NULL == fps)
+	{
+		fps = mp_search (0xf0000, 0x10000);
+	}
+
+	/* 기본 설정(type != 0)은 테이블이 없는 오래된 2-CPU 시스템용이라 지원하지 않음 */
+	if ((NULL == fps) || (0 == fps->config) || (0 != fps->type))
+	{
+		return NULL;
+	}
+
+	conf = ptov (fps->config);
+	if ((0 != memcmp (conf->signature, "PCMP", 4))
+			|| !mp_checksum (conf, conf->length))
+	{
+		return NULL;
+	}
+
+	return conf;
+}
@@ -0,0 +1,303 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/loader.h"
+#include "threads/slab.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* 지연(lazy) FPU 전환.
+
+   스레드마다 x87/SSE 레지스터를 저장할 struct fpu_state를 두고, 스레드가
+   처음으로 FPU 명령을 실행할 때 할당함. FPU를 쓰지 않는 스레드(커널
+   스레드 전부와 대부분의 유저 프로그램)는 저장 공간도, 전환 비용도 없음.
+
+   스레드를 전환할 때 CR0.TS를 켜두면 새 스레드가 FPU 명령을 처음 실행할
+   때 #NM이 발생하고, 그때 fpu_trap()이 TS를 끄고 그 스레드의 상태를
+   복원함. 그 뒤로는 다음 전환까지 예외 없이 레지스터를 그대로 씀.
+
+   나가는 스레드의 상태는 이번에 FPU를 썼을 때(TS가 꺼져 있을 때)만 바로
+   저장함. 그래서 실행 중이 아닌 스레드의 저장 공간은 항상 최신이고, 다른
+   CPU로 옮겨가도 레지스터를 가져올 필요가 없음. 저장한 뒤에도 레지스터에는
+   같은 값이 남아있으므로, CPU의 fpu_owner가 자기 자신이고 마지막으로 FPU를
+   쓴 CPU(fpu_cpu)가 이 CPU라면 복원도 건너뜀. 종료된 스레드의 페이지를
+   다른 스레드가 재사용해도 init_thread()가 fpu_cpu를 지우므로 잘못 건너뛰지
+   않음.
+
+   불변식: TS가 꺼져 있다면 레지스터에는 현재 스레드의 상태가 있음.
+
+   커널은 -mno-sse로 컴파일하고 인터럽트 때 FPU 상태를 저장하지 않으므로,
+   커널 코드에서 SSE를 쓰려면 fpu_kernel_begin()과 fpu_kernel_end() 사이에서
+   써야 함. */
+
+#define CR0_MP 0x00000002       /* Monitor coprocessor. */
+#define CR0_EM 0x00000004       /* (Floating-point) Emulation. */
+#define CR0_TS 0x00000008       /* Task switched. */
+#define CR4_OSFXSR (1 << 9)     /* FXSAVE/FXRSTOR와 SSE 명령 허용. */
+#define CR4_OSXMMEXCPT (1 << 10) /* SSE 예외를 #XF로 받음. */
+
+/* MXCSR의 초기값: 모든 SSE 예외를 마스크. */
+#define MXCSR_DEFAULT 0x1f80
+
+/* 스레드별 FPU 상태의 슬랩 캐시. */
+static struct kmem_cache *fpu_cache;
+
+/* FPU를 처음 쓰는 스레드가 받는 상태. fpu_init()에서 FNINIT 직후의
+   상태를 저장해둠 */
+static struct fpu_state fpu_init_state;
+
+static intr_handler_func fpu_trap;
+
+static inline uint64_t
+rcr0 (void) {
+	uint64_t val;
+	asm volatile ("movq %%cr0, %0" : "=r" (val));
+	return val;
+}
+
+static inline void
+lcr0 (uint64_t val) {
+	asm volatile ("movq %0, %%cr0" : : "r" (val));
+}
+
+static inline uint64_t
+rcr4 (void) {
+	uint64_t val;
+	asm volatile ("movq %%cr4, %0" : "=r" (val));
+	return val;
+}
+
+static inline void
+lcr4 (uint64_t val) {
+	asm volatile ("movq %0, %%cr4" : : "r" (val));
+}
+
+/* CR0.TS를 끔 */
+static inline void
+clts (void) {
+	asm volatile ("clts");
+}
+
+/* CR0.TS를 켬 */
+static inline void
+stts (void) {
+	lcr0 (rcr0 () | CR0_TS);
+}
+
+static inline void
+fxsave (struct fpu_state *s) {
+	asm volatile ("fxsave64 %0" : "=m" (*s));
+}
+
+static inline void
+fxrstor (const struct fpu_state *s) {
+	asm volatile ("fxrstor64 %0" : : "m" (*s));
+}
+
+/* 이 CPU에서 FXSAVE와 SSE를 허용하고 TS를 켬 */
+static void
+fpu_init_cpu (void) {
+	lcr4 (rcr4 () | CR4_OSFXSR | CR4_OSXMMEXCPT);
+	lcr0 ((rcr0 () & ~CR0_EM) | CR0_MP | CR0_TS);
+	this_cpu ()->fpu_owner = NULL;
+}
+
+/* 부팅 CPU의 FPU를 초기화하고 #NM 핸들러를 등록. malloc_init()과
+   intr_init() 뒤에 호출 */
+void
+fpu_init (void) {
+	uint32_t mxcsr = MXCSR_DEFAULT;
+
+	fpu_init_cpu ();
+	clts ();
+	asm volatile ("fninit; ldmxcsr %0" : : "m" (mxcsr));
+	fxsave (&fpu_init_state);
+	stts ();
+
+	fpu_cache = kmem_cache_create ("fpu", sizeof (struct fpu_state), 16, NULL);
+	intr_register_int (7, 0, INTR_ON, fpu_trap,
+			"#NM Device Not Available Exception");
+}
+
+/* AP의 FPU를 초기화. ap_main()에서 스케줄링을 시작하기 전에 호출 */
+void
+fpu_init_ap (void) {
+	fpu_init_cpu ();
+}
+
+/* FPU 통계 출력 */
+void
+fpu_print_stats (void) {
+	long long trap_cnt = 0, restore_cnt = 0;
+
+	for (int i = 0; i < cpu_cnt; i++) {
+		trap_cnt += cpus[i].fpu_trap_cnt;
+		restore_cnt += cpus[i].fpu_restore_cnt;
+	}
+	printf ("FPU: %lld lazy traps, %lld state restores\n",
+			trap_cnt, restore_cnt);
+}
+
+/* #NM 핸들러. 현재 스레드가 TS가 켜진 채로 FPU 명령을 실행했으므로, 처음
+   이라면 상태를 할당하고, 레지스터에 다른 상태가 있다면 복원한 뒤 TS를 끔 */
+static void
+fpu_trap (struct intr_frame *f) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level;
+	struct cpu *c;
+
+	/* 커널 코드는 fpu_kernel_begin() 밖에서 FPU를 쓰면 안 됨 */
+	if (f->cs != SEL_UCSEG) {
+		intr_dump_frame (f);
+		PANIC ("Kernel bug - FPU used outside fpu_kernel_begin()");
+	}
+
+	if (t->fpu == NULL) {
+		t->fpu = kmem_cache_alloc (fpu_cache);
+		if (t->fpu == NULL) {
+#ifdef USERPROG
+			t->exit_status = -1;
+#endif
+			thread_exit ();
+		}
+		memcpy (t->fpu, &fpu_init_state, sizeof *t->fpu);
+	}
+
+	/* 다른 CPU로 옮겨가지 않도록 인터럽트를 끄고 레지스터를 채움 */
+	old_level = intr_disable ();
+	c = this_cpu ();
+	clts ();
+	if (c->fpu_owner != t || t->fpu_cpu != c) {
+		fxrstor (t->fpu);
+		c->fpu_restore_cnt++;
+	}
+	c->fpu_owner = t;
+	t->fpu_cpu = c;
+	c->fpu_trap_cnt++;
+	intr_set_level (old_level);
+}
+
+/* 스레드 전환 직전에 schedule()이 인터럽트를 끈 채로 호출. PREV가 이번에
+   FPU를 썼다면 상태를 저장하고 TS를 켬 */
+void
+fpu_switch (struct thread *prev) {
+	if (prev->fpu != NULL && !(rcr0 () & CR0_TS)) {
+		fxsave (prev->fpu);
+		stts ();
+	}
+}
+
+/* 현재 스레드의 레지스터 상태를 저장 공간에 저장. 다른 스레드가 현재
+   스레드의 상태를 읽기 전에(fork 등) 호출 */
+void
+fpu_save (void) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level = intr_disable ();
+
+	if (t->fpu != NULL && !(rcr0 () & CR0_TS))
+		fxsave (t->fpu);
+	intr_set_level (old_level);
+}
+
+/* PARENT의 FPU 상태를 CHILD에 복사. PARENT는 미리 fpu_save()를 호출해야
+   함. 메모리가 부족하면 false */
+bool
+fpu_fork (struct thread *child, const struct thread *parent) {
+	ASSERT (child->fpu == NULL);
+
+	if (parent->fpu == NULL)
+		return true;
+
+	child->fpu = kmem_cache_alloc (fpu_cache);
+	if (child->fpu == NULL)
+		return false;
+	memcpy (child->fpu, parent->fpu, sizeof *child->fpu);
+	return true;
+}
+
+/* 종료된 스레드 T의 FPU 상태를 해제 */
+void
+fpu_release (struct thread *t) {
+	if (t->fpu != NULL) {
+		kmem_cache_free (fpu_cache, t->fpu);
+		t->fpu = NULL;
+	}
+}
+
+/* 현재 스레드의 FPU 상태를 버림. exec가 새 프로그램을 올리기 전에 호출.
+   TS를 켜두므로 새 프로그램이 FPU를 처음 쓰면 #NM에서 초기 상태를 받음 */
+void
+fpu_reset (void) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level = intr_disable ();
+	struct cpu *c = this_cpu ();
+
+	stts ();
+	if (c->fpu_owner == t)
+		c->fpu_owner = NULL;
+	t->fpu_cpu = NULL;
+	fpu_release (t);
+	intr_set_level (old_level);
+}
+
+/* 커널 코드에서 SSE를 쓰기 시작. 현재 스레드의 상태가 레지스터에 있다면
+   저장해두고, fpu_kernel_end()까지 인터럽트를 끔. 반환값은
+   fpu_kernel_end()에 넘김 */
+enum intr_level
+fpu_kernel_begin (void) {
+	enum intr_level old_level = intr_disable ();
+	struct cpu *c = this_cpu ();
+
+	if (!(rcr0 () & CR0_TS))
+		fxsave (thread_current ()->fpu);
+	else
+		clts ();
+	c->fpu_owner = NULL;
+
+	return old_level;
+}
+
+/* 커널 코드에서 SSE 사용을 마침. TS를 다시 켜서 스레드가 다음에 FPU를
+   쓸 때 저장해둔 상태를 복원하게 함 */
+void
+fpu_kernel_end (enum intr_level old_level) {
+	stts ();
+	intr_set_level (old_level);
+}
+
+/* 페이지 SRC를 DST에 복사. CONFIG_SSE로 빌드했다면 SSE2로 한 번에 64바이트씩
+   복사함 */
+void
+fpu_copy_page (void *dst, const void *src) {
+	ASSERT (pg_ofs (dst) == 0 && pg_ofs (src) == 0);
+
+#ifdef CONFIG_SSE
+	enum intr_level old_level = fpu_kernel_begin ();
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	size_t cnt = PGSIZE / 64;
+
+	/* -mno-sse로는 xmm 레지스터를 clobber로 적을 수 없지만, 컴파일러가
+	   xmm 레지스터를 쓰지 않으므로 적지 않아도 됨 */
+	asm volatile ("1:\n\t"
+			"movdqa 0(%1), %%xmm0\n\t"
+			"movdqa 16(%1), %%xmm1\n\t"
+			"movdqa 32(%1), %%xmm2\n\t"
+			"movdqa 48(%1), %%xmm3\n\t"
+			"movdqa %%xmm0, 0(%0)\n\t"
+			"movdqa %%xmm1, 16(%0)\n\t"
+			"movdqa %%xmm2, 32(%0)\n\t"
+			"movdqa %%xmm3, 48(%0)\n\t"
+			"addq $64, %0\n\t"
+			"addq $64, %1\n\t"
+			"decq %2\n\t"
+			"jnz 1b"
+			: "+r" (d), "+r" (s), "+r" (cnt)
+			: : "memory");
+	fpu_kernel_end (old_level);
+#else
+	memcpy (dst, src, PGSIZE);
+#endif
+}
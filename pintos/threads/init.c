@@ -11,8 +11,11 @@
 #include "devices/kbd.h"
 #include "devices/input.h"
 #include "devices/serial.h"
+#include "devices/timeout.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/cpu.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -20,6 +23,9 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/sched-trace.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -94,6 +100,7 @@ main (void) {
 
 	/* Initialize interrupt handlers. */
 	intr_init ();
+	fpu_init ();
 	timer_init ();
 	kbd_init ();
 	input_init ();
@@ -105,6 +112,8 @@ main (void) {
 	thread_start ();
 	serial_init_queue ();
 	timer_calibrate ();
+	smp_init ();
+	intr_work_start ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -221,11 +230,23 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-donate-depth"))
+			lock_donation_depth = atoi (value);
+		else if (!strcmp (name, "-lock-spin"))
+			lock_spin_limit = atoi (value);
+		else if (!strcmp (name, "-sched-trace"))
+			sched_trace_enabled = true;
+		else if (!strcmp (name, "-timer-freq"))
+			timer_freq = atoi (value);
+		else if (!strcmp (name, "-time-slice"))
+			thread_time_slice_ms = atoi (value);
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+		else if (!strcmp (name, "-user-rt"))
+			user_rt_allowed = true;
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -252,6 +273,12 @@ run_task (char **argv) {
 	printf ("Execution of '%s' complete.\n", task);
 }
 
+/* Prints the scheduler latency histograms collected so far. */
+static void
+print_sched_trace (char **argv UNUSED) {
+	sched_trace_print ();
+}
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -266,6 +293,7 @@ run_actions (char **argv) {
 	/* Table of supported actions. */
 	static const struct action actions[] = {
 		{"run", 2, run_task},
+		{"sched-trace", 1, print_sched_trace},
 #ifdef FILESYS
 		{"ls", 1, fsutil_ls},
 		{"cat", 2, fsutil_cat},
@@ -320,14 +348,21 @@ usage (void) {
 			"  put FILE           Put FILE into file system from scratch disk.\n"
 			"  get FILE           Get FILE from file system into scratch disk.\n"
 #endif
+			"  sched-trace        Print scheduler histograms (needs -sched-trace).\n"
 			"\nOptions:\n"
 			"  -h                 Print this help message and power off.\n"
 			"  -q                 Power off VM after actions or on panic.\n"
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -donate-depth=N    Propagate priority donation up to N locks deep.\n"
+			"  -lock-spin=N       Spin up to N times on a held lock before sleeping.\n"
+			"  -sched-trace       Record scheduler wait and run-time histograms.\n"
+			"  -timer-freq=HZ     Take HZ timer interrupts per second (19...1000).\n"
+			"  -time-slice=MS     Preempt threads after MS milliseconds (1...1000).\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+			"  -user-rt           Let user programs use SCHED_FIFO and SCHED_RR.\n"
 #endif
 			);
 	power_off ();
@@ -353,12 +388,20 @@ power_off (void) {
 static void
 print_stats (void) {
 	timer_print_stats ();
+	timeout_print_stats ();
+	intr_print_stats ();
+	fpu_print_stats ();
+	kmem_print_stats ();
+	palloc_print_stats ();
 	thread_print_stats ();
+	lock_stat_print ();
+	sched_trace_print ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
 	console_print_stats ();
 	kbd_print_stats ();
+	input_print_stats ();
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
@@ -3,6 +3,8 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "devices/lapic.h"
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
@@ -100,8 +102,11 @@ static const char *intr_names[INTR_CNT];
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
    interrupt returns. */
-static bool in_external_intr;   /* Are we processing an external interrupt? */
-static bool yield_on_return;    /* Should we yield on interrupt return? */
+/* 두 상태는 CPU마다 따로 있으며 struct cpu의 in_external_intr, */
+/* yield_on_return에 둠. */
+/* 8259A PIC가 보내는 0x20...0x2f와 Local APIC가 보내는 0xf0...0xfe가 외부 인터럽트 */
+#define is_pic_vec(vec) ((vec) >= 0x20 && (vec) <= 0x2f)
+#define is_lapic_vec(vec) ((vec) >= LAPIC_VEC_MIN && (vec) != LAPIC_SPURIOUS_VEC)
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
@@ -110,6 +115,9 @@ static void pic_end_of_interrupt (int irq);
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 
+/* 미뤄둔 작업. */
+static void intr_worker (void *cpu_);
+
 /* Returns the current interrupt status. */
 enum intr_level
 intr_get_level (void) {
@@ -167,6 +175,12 @@ intr_init (void) {
 	/* Initialize interrupt controller. */
 	pic_init ();
 
+	/* 모든 CPU의 작업 큐를 미리 초기화. 작업 스레드는 intr_work_start()가 만듦 */
+	for (i = 0; i < CPU_MAX; i++) {
+		spinlock_init (&cpus[i].intr_work_lock, "intr_work");
+		list_init (&cpus[i].intr_work);
+	}
+
 	/* Initialize IDT. */
 	for (i = 0; i < INTR_CNT; i++) {
 		make_intr_gate(&idt[i], intr_stubs[i], 0);
@@ -201,6 +215,19 @@ intr_init (void) {
 	intr_names[17] = "#AC Alignment Check Exception";
 	intr_names[18] = "#MC Machine-Check Exception";
 	intr_names[19] = "#XF SIMD Floating-Point Exception";
+	intr_names[LAPIC_SPURIOUS_VEC] = "LAPIC Spurious Interrupt";
+}
+
+/* AP가 BSP와 같은 IDT를 쓰도록 함. AP의 TSS를 만든 뒤에 호출 */
+void
+intr_init_ap (void) {
+#ifdef USERPROG
+	/* Load TSS. */
+	ltr (SEL_TSS);
+#endif
+
+	/* Load IDT register. */
+	lidt(&idt_desc);
 }
 
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
@@ -227,7 +254,7 @@ register_handler (uint8_t vec_no, int dpl, enum intr_level level,
 void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 		const char *name) {
-	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+	ASSERT (is_pic_vec (vec_no) || is_lapic_vec (vec_no));
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -248,7 +275,7 @@ void
 intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 		intr_handler_func *handler, const char *name)
 {
-	ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+	ASSERT (!is_pic_vec (vec_no) && vec_no < LAPIC_VEC_MIN);
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
@@ -256,7 +283,14 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
    and false at all other times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	/* 외부 인터럽트 처리 중에는 인터럽트가 꺼져 있으므로, 켜져 있다면 */
+	/* 다른 CPU로 옮겨갈 수 있는 상태에서 this_cpu()를 읽지 않고 바로 반환 */
+	if (intr_get_level () == INTR_ON)
+	{
+		return false;
+	}
+
+	return this_cpu ()->in_external_intr;
 }
 
 /* During processing of an external interrupt, directs the
@@ -266,9 +300,145 @@ intr_context (void) {
 void
 intr_yield_on_return (void) {
 	ASSERT (intr_context ());
-	yield_on_return = true;
+	this_cpu ()->yield_on_return = true;
 }
 
+/* 미뤄둔 작업 W를 FUNC(AUX)를 실행하도록 초기화. 아직 큐에 넣지는 않음 */
+void
+intr_work_init (struct intr_work *w, intr_work_func *func, void *aux) {
+	ASSERT (w != NULL);
+	ASSERT (func != NULL);
+
+	w->func = func;
+	w->aux = aux;
+	w->pending = false;
+}
+
+/* 작업 W를 현재 CPU의 작업 큐에 넣고, 잠들어 있는 작업 스레드를 깨움.
+   이미 대기 중이라면 아무것도 하지 않고 false, 새로 넣었다면 true.
+   외부 인터럽트 핸들러에서 부르는 것이 보통이지만 어디서든 부를 수 있음.
+   작업 스레드가 아직 없는 부팅 초기에는 그 자리에서 바로 실행함 */
+bool
+intr_defer (struct intr_work *w) {
+	enum intr_level old_level;
+	struct cpu *c;
+	bool preempt = false;
+
+	ASSERT (w != NULL);
+
+	old_level = intr_disable ();
+	c = this_cpu ();
+	if (NULL == c->intr_worker)
+	{
+		intr_set_level (old_level);
+		w->func (w->aux);
+		return true;
+	}
+
+	spin_lock (&c->intr_work_lock);
+	if (w->pending)
+	{
+		spin_unlock (&c->intr_work_lock);
+		intr_set_level (old_level);
+		return false;
+	}
+
+	w->pending = true;
+	list_push_back (&c->intr_work, &w->elem);
+	c->intr_work_cnt++;
+
+	/* 한 번 깨우면 쌓인 작업을 모두 실행하므로, 잠들어 있을 때만 깨움 */
+	if (c->intr_worker_idle)
+	{
+		c->intr_worker_idle = false;
+		thread_unblock (c->intr_worker);
+		preempt = thread_should_preempt (c->intr_worker);
+	}
+	spin_unlock (&c->intr_work_lock);
+
+	/* 호출자가 인터럽트를 꺼둔 채라면 원자성을 기대할 수 있으므로 양보하지 않음 */
+	if (preempt && (intr_context () || (INTR_ON == old_level)))
+	{
+		thread_preempt ();
+	}
+	intr_set_level (old_level);
+
+	return true;
+}
+
+/* 스레드 스케줄링이 시작된 뒤 CPU마다 작업 스레드를 하나씩 만듦. */
+/* smp_init() 뒤에 호출. 그 전에 미룬 작업은 intr_defer()가 바로 실행함 */
+void
+intr_work_start (void) {
+	for (int i = 0; i < cpu_cnt; i++)
+	{
+		char name[16];
+
+		snprintf (name, sizeof name, "intrd%d", i);
+		if (TID_ERROR == thread_create (name, PRI_MAX, intr_worker, &cpus[i]))
+		{
+			PANIC ("cannot create %s", name);
+		}
+	}
+}
+
+/* 미뤄둔 작업 통계 출력 */
+void
+intr_print_stats (void) {
+	long long works = 0, batches = 0;
+
+	for (int i = 0; i < cpu_cnt; i++)
+	{
+		works += cpus[i].intr_work_cnt;
+		batches += cpus[i].intr_batch_cnt;
+	}
+
+	printf ("Interrupt: %lld works deferred, run in %lld batches\n",
+			works, batches);
+}
+
+/* CPU_의 작업 큐를 비우는 작업 스레드. 큐가 빌 때까지 작업을 하나씩 꺼내 */
+/* 인터럽트를 켠 채로 실행하고, 비면 intr_defer()가 깨울 때까지 잠듦 */
+static void
+intr_worker (void *cpu_) {
+	struct cpu *c = cpu_;
+	enum intr_level old_level;
+
+	/* 이 CPU에 미뤄진 작업만 처리하므로 다른 CPU로 옮겨가지 않도록 고정하고, */
+	/* 인터럽트가 반환되자마자 하반부가 실행되도록 가장 높은 순위로 올림 */
+	thread_bind_cpu (c);
+	thread_set_class (SCHED_FIFO, PRI_MAX);
+
+	old_level = spin_lock_irqsave (&c->intr_work_lock);
+	c->intr_worker = thread_current ();
+	for (;;)
+	{
+		while (list_empty (&c->intr_work))
+		{
+			c->intr_worker_idle = true;
+			thread_block_unlock (&c->intr_work_lock);
+			spin_lock (&c->intr_work_lock);
+		}
+		c->intr_batch_cnt++;
+
+		/* 실행 도중에 다시 넣을 수 있도록 꺼내면서 pending을 지움 */
+		while (!list_empty (&c->intr_work))
+		{
+			struct intr_work *w = list_entry (list_pop_front (&c->intr_work),
+					struct intr_work, elem);
+			intr_work_func *func = w->func;
+			void *aux = w->aux;
+
+			w->pending = false;
+			spin_unlock_irqrestore (&c->intr_work_lock, old_level);
+
+			func (aux);
+
+			old_level = spin_lock_irqsave (&c->intr_work_lock);
+		}
+	}
+}
+
 /* 8259A Programmable Interrupt Controller. */
 
 /* Every PC has two 8259A Programmable Interrupt Controller (PIC)
@@ -332,25 +502,28 @@ void
 intr_handler (struct intr_frame *frame) {
 	bool external;
 	intr_handler_func *handler;
+	struct cpu *c = NULL;
 
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	external = is_pic_vec (frame->vec_no) || is_lapic_vec (frame->vec_no);
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
-		in_external_intr = true;
-		yield_on_return = false;
+		c = this_cpu ();
+		c->in_external_intr = true;
+		c->yield_on_return = false;
 	}
 
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
 	if (handler != NULL)
 		handler (frame);
-	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f
+			|| frame->vec_no == LAPIC_SPURIOUS_VEC) {
 		/* There is no handler, but this interrupt can trigger
 		   spuriously due to a hardware fault or hardware race
 		   condition.  Ignore it. */
@@ -366,11 +539,14 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (intr_context ());
 
-		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		c->in_external_intr = false;
+		if (is_pic_vec (frame->vec_no))
+			pic_end_of_interrupt (frame->vec_no);
+		else
+			lapic_eoi ();
 
-		if (yield_on_return)
-			thread_yield ();
+		if (c->yield_on_return)
+			thread_yield_preempted ();
 	}
 }
 
@@ -0,0 +1,71 @@
+#include "threads/lockstat.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/spinlock.h"
+#include "intrinsic.h"
+
+/* 등록된 모든 struct lock_stat을 등록한 순서대로 이은 리스트. */
+/* palloc_init()보다 먼저 쓰이므로 초기화가 필요 없는 단일 연결 리스트를 씀 */
+static struct lock_stat *stats;
+static struct lock_stat **stats_tail = &stats;
+static struct spinlock stats_lock = { .name = "lockstat" };
+
+/* 통계 S를 NAME이라는 이름으로 초기화하고 출력 목록에 등록. */
+/* S는 커널이 끝날 때까지 남아있어야 하므로 정적 변수여야 함 */
+void
+lock_stat_init (struct lock_stat *s, const char *name) {
+	enum intr_level old_level;
+
+	ASSERT (s != NULL);
+
+	s->name = name;
+	s->acquire_cnt = 0;
+	s->contend_cnt = 0;
+	s->spin_cnt = 0;
+	s->hold_cycles = 0;
+	s->acquired_at = 0;
+	s->next = NULL;
+
+	old_level = spin_lock_irqsave (&stats_lock);
+	*stats_tail = s;
+	stats_tail = &s->next;
+	spin_unlock_irqrestore (&stats_lock, old_level);
+}
+
+/* S가 붙은 락을 방금 얻었음. 바로 얻지 못했다면 CONTENDED, */
+/* 그러고도 잠들지 않았다면 SPUN을 true로 줌 */
+void
+lock_stat_acquired (struct lock_stat *s, bool contended, bool spun) {
+	s->acquire_cnt++;
+	if (contended)
+	{
+		s->contend_cnt++;
+	}
+	if (spun)
+	{
+		s->spin_cnt++;
+	}
+	s->acquired_at = rdtsc ();
+}
+
+/* S가 붙은 락을 곧 놓음. 아직 락을 잡고 있을 때 호출 */
+void
+lock_stat_released (struct lock_stat *s) {
+	s->hold_cycles += rdtsc () - s->acquired_at;
+}
+
+/* 등록된 락 통계를 출력 */
+void
+lock_stat_print (void) {
+	for (struct lock_stat *s = stats; NULL != s; s = s->next)
+	{
+		if (0 == s->acquire_cnt)
+		{
+			continue;
+		}
+
+		printf ("Lock %s: %llu acquires, %llu contended, %llu spun, "
+				"%llu cycles avg hold\n", s->name, s->acquire_cnt, s->contend_cnt,
+				s->spin_cnt, s->hold_cycles / s->acquire_cnt);
+	}
+}
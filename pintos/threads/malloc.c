@@ -5,8 +5,9 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/palloc.h"
-#include "threads/synch.h"
+#include "threads/spinlock.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
@@ -34,12 +35,27 @@
    with the page allocator and sticking the allocation size at
    the beginning of the allocated block's arena header. */
 
+/* CPU별 매거진.
+
+   위의 free list(디포)는 디스크립터마다 하나라서 모든 CPU의 malloc(),
+   free()가 그 락에서 줄을 섬. 그래서 CPU마다, 크기 클래스마다 빈 블록을
+   몇 개 쌓아둔 작은 LIFO 스택(매거진)을 두고, 보통은 인터럽트만 끈 채로
+   매거진에서 꺼내거나 넣고 끝냄. 매거진이 비면 디포에서 절반만큼 한 번에
+   채우고, 가득 차면 오래된 절반을 한 번에 디포로 돌려보냄. 그래서 락은
+   많아야 블록 몇 개당 한 번만 잡음.
+   매거진에 있는 블록은 디포 입장에서는 할당된 블록이므로, 그 아레나는
+   블록이 디포로 돌아올 때까지 페이지 할당자에게 돌아가지 않음. 큰 블록이
+   매거진에 너무 많은 메모리를 붙잡지 않도록 매거진 크기는 블록 크기에
+   반비례해서 한 페이지를 넘지 않게 함 (최소 2개). */
 /* Descriptor. */
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
+	size_t mag_size;            /* 매거진 하나에 담을 수 있는 블록 수. */
 	struct list free_list;      /* List of free blocks. */
-	struct lock lock;           /* Lock. */
+	struct spinlock lock;       /* Lock. */
+	struct lock_stat stat;      /* 락 경쟁 프로파일. */
+	char name[16];              /* 프로파일에 출력할 이름. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -58,11 +74,26 @@ struct block {
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+#define DESC_MAX 10
+static struct desc descs[DESC_MAX]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* 매거진 하나가 담을 수 있는 최대 블록 수. */
+#define MAG_ROUNDS 16
+
+/* 매거진. 주인 CPU에서 인터럽트를 끈 채로만 접근 */
+struct magazine {
+	void *rounds[MAG_ROUNDS];   /* 빈 블록. 마지막 원소가 가장 최근에 해제됨. */
+	size_t cnt;                 /* ROUNDS에 들어있는 블록 수. */
+} __attribute__ ((aligned (CACHE_LINE_SIZE)));
+
+/* CPU별, 디스크립터별 매거진. cpus[i]에서 descs[j]의 매거진이 magazines[i][j] */
+static struct magazine magazines[CPU_MAX][DESC_MAX];
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static size_t depot_get (struct desc *, void **blocks, size_t cnt);
+static void depot_put (struct desc *, void **blocks, size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -74,8 +105,16 @@ malloc_init (void) {
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+		d->mag_size = PGSIZE / block_size;
+		if (d->mag_size > MAG_ROUNDS)
+			d->mag_size = MAG_ROUNDS;
+		if (d->mag_size < 2)
+			d->mag_size = 2;
 		list_init (&d->free_list);
-		lock_init (&d->lock);
+		snprintf (d->name, sizeof d->name, "malloc-%zu", block_size);
+		spinlock_init (&d->lock, d->name);
+		lock_stat_init (&d->stat, d->name);
+		spinlock_profile (&d->lock, &d->stat);
 	}
 }
 
@@ -84,8 +123,10 @@ malloc_init (void) {
 void *
 malloc (size_t size) {
 	struct desc *d;
-	struct block *b;
+	struct magazine *m;
 	struct arena *a;
+	void *b;
+	enum intr_level old_level;
 
 	/* A null pointer satisfies a request for 0 bytes. */
 	if (size == 0)
@@ -112,34 +153,13 @@ malloc (size_t size) {
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
-
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
-		}
-
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
-	}
-
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
-	lock_release (&d->lock);
+	/* 이 CPU의 매거진에서 꺼냄. 비어있다면 디포에서 절반만큼 채움 */
+	old_level = intr_disable ();
+	m = &magazines[this_cpu ()->id][d - descs];
+	if (m->cnt == 0)
+		m->cnt = depot_get (d, m->rounds, d->mag_size / 2);
+	b = m->cnt > 0 ? m->rounds[--m->cnt] : NULL;
+	intr_set_level (old_level);
 	return b;
 }
 
@@ -213,24 +233,20 @@ free (void *p) {
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
+			enum intr_level old_level = intr_disable ();
+			struct magazine *m = &magazines[this_cpu ()->id][d - descs];
 
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
+			/* 이 CPU의 매거진에 넣음. 가득 찼다면 오래된 절반을 디포로 돌려보냄 */
+			if (m->cnt == d->mag_size) {
+				size_t half = d->mag_size / 2;
 
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
+				depot_put (d, m->rounds, half);
+				m->cnt -= half;
+				memmove (m->rounds, m->rounds + half, m->cnt * sizeof *m->rounds);
 			}
+			m->rounds[m->cnt++] = b;
 
-			lock_release (&d->lock);
+			intr_set_level (old_level);
 		} else {
 			/* It's a big block.  Free its pages. */
 			palloc_free_multiple (a, a->free_cnt);
@@ -239,6 +255,82 @@ free (void *p) {
 	}
 }
 
+/* 디스크립터 D의 디포에서 빈 블록을 CNT개까지 꺼내 BLOCKS에 담고 꺼낸 수를 반환.
+   디포가 비어있다면 새 아레나를 하나 만들어 채우며, 페이지를 얻지 못하면 0.
+   인터럽트를 끈 채로 호출 */
+static size_t
+depot_get (struct desc *d, void **blocks, size_t cnt) {
+	size_t n = 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&d->lock);
+
+	/* If the free list is empty, create a new arena. */
+	if (list_empty (&d->free_list)) {
+		struct arena *a;
+		size_t i;
+
+		/* Allocate a page. */
+		a = palloc_get_page (0);
+		if (a == NULL) {
+			spin_unlock (&d->lock);
+			return 0;
+		}
+
+		/* Initialize arena and add its blocks to the free list. */
+		a->magic = ARENA_MAGIC;
+		a->desc = d;
+		a->free_cnt = d->blocks_per_arena;
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_push_back (&d->free_list, &b->free_elem);
+		}
+	}
+
+	/* Get blocks from free list. */
+	while (n < cnt && !list_empty (&d->free_list)) {
+		struct block *b = list_entry (list_pop_front (&d->free_list),
+				struct block, free_elem);
+
+		block_to_arena (b)->free_cnt--;
+		blocks[n++] = b;
+	}
+
+	spin_unlock (&d->lock);
+	return n;
+}
+
+/* BLOCKS에 있는 디스크립터 D의 블록 CNT개를 디포로 돌려보냄.
+   아레나의 블록이 모두 비었다면 아레나를 페이지 할당자에게 돌려줌.
+   인터럽트를 끈 채로 호출 */
+static void
+depot_put (struct desc *d, void **blocks, size_t cnt) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&d->lock);
+	for (size_t n = 0; n < cnt; n++) {
+		struct block *b = blocks[n];
+		struct arena *a = block_to_arena (b);
+
+		/* Add block to free list. */
+		list_push_front (&d->free_list, &b->free_elem);
+
+		/* If the arena is now entirely unused, free it. */
+		if (++a->free_cnt >= d->blocks_per_arena) {
+			size_t i;
+
+			ASSERT (a->free_cnt == d->blocks_per_arena);
+			for (i = 0; i < d->blocks_per_arena; i++) {
+				struct block *b = arena_to_block (a, i);
+				list_remove (&b->free_elem);
+			}
+			palloc_free_page (a);
+		}
+	}
+	spin_unlock (&d->lock);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
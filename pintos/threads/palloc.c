@@ -2,14 +2,16 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
+#include "threads/spinlock.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -26,22 +28,106 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
+/* 버디 할당자.
+
+   각 풀의 빈 페이지를 크기가 2^k 페이지이고 풀 시작에서 2^k 페이지
+   단위로 정렬된 블록들로 나눠 차수(k)별 free list에 둠. 할당할 때는
+   요청을 담을 수 있는 가장 작은 차수의 블록을 꺼내 반씩 쪼개고,
+   2의 거듭제곱이 아닌 요청이라면 남는 뒷부분을 바로 돌려줌. 해제할 때는
+   짝(buddy) 블록도 비어있는 동안 합쳐서 한 차수씩 올림. 그래서 할당과
+   해제 모두 O(log n)이고, 연속된 빈 페이지가 큰 블록으로 다시 모임.
+
+   빈 블록의 리스트 원소는 그 블록의 첫 페이지 안에 둠. 페이지마다 그
+   페이지에서 시작하는 빈 블록의 차수를 order_map에 기록해서 짝이 빈
+   블록인지 바로 알 수 있음. used_map은 할당 여부를 페이지 단위로 기록해서
+   잘못된 해제를 잡는 데 씀. CPU별 캐시와 zero_list에 들어간 페이지는
+   used_map에서는 할당된 페이지로 남으므로, 디버그 빌드에서는 cache_map에
+   따로 기록해서 그런 페이지를 다시 해제하는 것도 잡음. */
+
+/* 블록 차수 수. 가장 큰 블록은 2^(ORDER_CNT - 1) 페이지 */
+#define ORDER_CNT 20
+
+/* order_map에서 빈 블록의 첫 페이지가 아님을 나타내는 값. */
+#define ORDER_NONE UINT8_MAX
+
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
+	struct spinlock lock;           /* Mutual exclusion. */
+	struct lock_stat stat;          /* 락 경쟁 프로파일. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
+#ifndef NDEBUG
+	struct bitmap *cache_map;       /* CPU별 캐시나 zero_list에 있는 페이지. */
+#endif
 	uint8_t *base;                  /* Base of pool. */
+	size_t page_cnt;                /* 풀의 페이지 수. */
+	uint8_t *order_map;             /* 페이지마다 시작하는 빈 블록의 차수. */
+	struct list free_lists[ORDER_CNT]; /* 차수별 빈 블록. */
+	size_t free_cnt;                /* 빈 페이지 수. */
+
+	struct spinlock zero_lock;      /* zero_list를 보호. */
+	struct list zero_list;          /* 미리 0으로 채운 페이지. */
+	size_t zero_cnt;                /* zero_list의 페이지 수. */
 };
 
+/* 빈 블록의 첫 페이지에 들어가는 리스트 원소. */
+struct free_block {
+	struct list_elem elem;
+};
+
+/* 미리 0으로 채운 페이지.
+
+   idle 스레드가 할 일이 없을 때 palloc_prezero()로 풀에서 페이지를 꺼내
+   0으로 채워서 풀의 zero_list에 모아둠. PAL_ZERO로 한 페이지를 요청하면
+   이 리스트에서 먼저 꺼내므로 요청한 쪽에서 memset을 하지 않아도 됨.
+   리스트 원소는 페이지 맨 앞에 두고 꺼낼 때 그 부분만 다시 0으로 채움.
+   zero_list의 페이지는 풀 입장에서는 할당된 페이지이며, 풀의 페이지가
+   떨어지면 CPU별 캐시와 함께 풀에 돌려보냄. 락 순서: zero_lock -> 풀의 락 */
+#define ZERO_HIGH 64
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* CPU별 페이지 캐시.
+
+   한 페이지 할당과 해제는 먼저 이 CPU의 캐시(빈 페이지 스택)에서 처리해서
+   풀의 락과 used_map을 건드리지 않음. 캐시가 비면 풀에서 PCP_BATCH개를
+   한 번에 가져오고, PCP_HIGH개로 가득 차면 오래된 PCP_BATCH개를 한 번에
+   돌려보냄. 캐시에 있는 페이지는 풀 입장에서는 할당된 페이지임.
+   캐시의 락은 보통 주인 CPU만 잡으므로 경쟁이 없고, 풀의 페이지가 떨어졌을
+   때 다른 CPU의 캐시를 비우는 데만 쓰임. 락 순서: 캐시의 락 -> 풀의 락 */
+#define PCP_BATCH 32
+#define PCP_HIGH (2 * PCP_BATCH)
+
+struct cpu_pages {
+	struct spinlock lock;           /* 캐시를 보호. */
+	size_t cnt;                     /* PAGES에 들어있는 페이지 수. */
+	void *pages[PCP_HIGH];          /* 빈 페이지. 마지막 원소가 가장 최근에 해제됨. */
+} __attribute__ ((aligned (CACHE_LINE_SIZE)));
+
+/* cpus[i]의 커널 풀 캐시가 cpu_pages[i][0], 유저 풀 캐시가 cpu_pages[i][1] */
+static struct cpu_pages cpu_pages[CPU_MAX][2];
+
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
+init_pool (struct pool *p, const char *name, void **bm_base, uint64_t start,
+		uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void buddy_init (struct pool *);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void buddy_insert (struct pool *, size_t page_idx, int order);
+static void buddy_remove (struct pool *, size_t page_idx, int order);
+static int order_for (size_t page_cnt);
+static void print_pool_stats (struct pool *, const char *name);
+static void *pcp_get (struct pool *);
+static void pcp_put (struct pool *, void *page);
+static void pcp_drain_all (struct pool *);
+static void cache_mark (struct pool *, void *page, bool cached);
+static void *zero_get (struct pool *);
+static bool zero_fill (struct pool *);
+static void zero_drain (struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -158,7 +244,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 						break;
 					}
 					// generate kernel pool
-					init_pool (&kernel_pool,
+					init_pool (&kernel_pool, "palloc-kernel",
 							&free_start, region_start, start + rem * PGSIZE);
 					// Transition to the next state
 					if (rem == size_in_pg) {
@@ -188,7 +274,7 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 	}
 
 	// generate the user pool
-	init_pool(&user_pool, &free_start, region_start, end);
+	init_pool(&user_pool, "palloc-user", &free_start, region_start, end);
 
 	// Iterate over the e820_entry. Setup the usable.
 	uint64_t usable_bound = (uint64_t) free_start;
@@ -250,6 +336,12 @@ palloc_init (void) {
 	printf ("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		  ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools (&base_mem, &ext_mem);
+	buddy_init (&kernel_pool);
+	buddy_init (&user_pool);
+	for (int i = 0; i < CPU_MAX; i++) {
+		spinlock_init (&cpu_pages[i][0].lock, "palloc-pcp");
+		spinlock_init (&cpu_pages[i][1].lock, "palloc-pcp");
+	}
 	return ext_mem.end;
 }
 
@@ -263,15 +355,38 @@ void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
 
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
-	void *pages;
+	void *pages = NULL;
 
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	/* 한 페이지라면 미리 0으로 채운 페이지나 이 CPU의 캐시에서 꺼냄 */
+	if (page_cnt == 1 && (flags & PAL_ZERO)) {
+		pages = zero_get (pool);
+		if (pages != NULL)
+			return pages;
+	}
+	if (page_cnt == 1)
+		pages = pcp_get (pool);
+
+	/* 여러 페이지이거나 캐시에 채울 페이지가 없었다면 풀에서 바로 할당. */
+	/* 그래도 없다면 다른 CPU의 캐시와 미리 0으로 채운 페이지를 모두 */
+	/* 돌려받고 다시 시도 */
+	for (int try = 0; pages == NULL && try < 2; try++) {
+		/* 스케줄러가 sched_lock을 잡은 채로 종료된 스레드의 페이지를 */
+		/* 해제하므로 잠들 수 있는 락 대신 스핀락을 씀 */
+		enum intr_level old_level;
+		size_t page_idx;
+
+		if (try > 0) {
+			pcp_drain_all (pool);
+			zero_drain (pool);
+		}
+
+		old_level = spin_lock_irqsave (&pool->lock);
+		page_idx = buddy_alloc (pool, page_cnt);
+		spin_unlock_irqrestore (&pool->lock, old_level);
+
+		if (page_idx != BITMAP_ERROR)
+			pages = pool->base + PGSIZE * page_idx;
+	}
 
 	if (pages) {
 		if (flags & PAL_ZERO)
@@ -301,6 +416,7 @@ void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
 	size_t page_idx;
+	enum intr_level old_level;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
@@ -318,8 +434,22 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+
+	/* 한 페이지라면 이 CPU의 캐시에 넣음 */
+	if (page_cnt == 1) {
+		ASSERT (bitmap_test (pool->used_map, page_idx));
+		pcp_put (pool, pages);
+		return;
+	}
+
+	old_level = spin_lock_irqsave (&pool->lock);
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+#ifndef NDEBUG
+	ASSERT (bitmap_none (pool->cache_map, page_idx, page_cnt));
+#endif
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free (pool, page_idx, page_cnt);
+	spin_unlock_irqrestore (&pool->lock, old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -330,16 +460,38 @@ palloc_free_page (void *page) {
 
 /* Initializes pool P as starting at START and ending at END */
 static void
-init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
+init_pool (struct pool *p, const char *name, void **bm_base, uint64_t start,
+		uint64_t end) {
   /* We'll put the pool's used_map at its base.
      Calculate the space needed for the bitmap
      and subtract it from the pool's size. */
+	/* 디버그 빌드라면 cache_map을, 그 뒤에 order_map을 used_map 바로 뒤에 둠 */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t map_size = ROUND_UP (bitmap_buf_size (pgcnt), sizeof (long));
+	size_t maps_size = map_size;
+#ifndef NDEBUG
+	maps_size += map_size;
+#endif
+	size_t bm_pages = DIV_ROUND_UP (maps_size + pgcnt, PGSIZE) * PGSIZE;
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	spinlock_init (&p->lock, name);
+	lock_stat_init (&p->stat, name);
+	spinlock_profile (&p->lock, &p->stat);
+	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, map_size);
 	p->base = (void *) start;
+	p->page_cnt = pgcnt;
+#ifndef NDEBUG
+	p->cache_map = bitmap_create_in_buf (pgcnt, (uint8_t *) *bm_base + map_size,
+			map_size);
+#endif
+	p->order_map = (uint8_t *) *bm_base + maps_size;
+	memset (p->order_map, ORDER_NONE, pgcnt);
+	for (int order = 0; order < ORDER_CNT; order++)
+		list_init (&p->free_lists[order]);
+	p->free_cnt = 0;
+	spinlock_init (&p->zero_lock, name);
+	list_init (&p->zero_list);
+	p->zero_cnt = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
@@ -356,3 +508,319 @@ page_from_pool (const struct pool *pool, void *page) {
 	size_t end_page = start_page + bitmap_size (pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* populate_pools()가 used_map에 빈 페이지로 표시한 페이지들로 풀 P의 */
+/* 빈 블록 리스트를 만듦. 한 페이지씩 넣으면서 짝과 합치므로 연속된 빈 */
+/* 페이지는 가능한 가장 큰 블록으로 모임 */
+static void
+buddy_init (struct pool *p) {
+	for (size_t i = 0; i < p->page_cnt; i++)
+		if (!bitmap_test (p->used_map, i))
+			buddy_insert (p, i, 0);
+}
+
+/* 풀 P에서 연속된 PAGE_CNT개의 페이지를 할당하고 첫 페이지의 번호를 */
+/* 반환. 빈 블록이 없다면 BITMAP_ERROR. P의 락을 잡고 있어야 함 */
+static size_t
+buddy_alloc (struct pool *p, size_t page_cnt) {
+	int want = order_for (page_cnt);
+	int order;
+	size_t page_idx;
+
+	ASSERT (spin_held (&p->lock));
+
+	if (page_cnt == 0 || want >= ORDER_CNT)
+		return BITMAP_ERROR;
+
+	/* 요청을 담을 수 있는 가장 작은 빈 블록을 찾음 */
+	for (order = want; order < ORDER_CNT; order++)
+		if (!list_empty (&p->free_lists[order]))
+			break;
+	if (order == ORDER_CNT)
+		return BITMAP_ERROR;
+
+	page_idx = pg_no (list_front (&p->free_lists[order])) - pg_no (p->base);
+	buddy_remove (p, page_idx, order);
+
+	/* 필요한 크기가 될 때까지 반으로 쪼개고 뒤쪽 절반은 돌려놓음 */
+	while (order > want) {
+		order--;
+		buddy_insert (p, page_idx + ((size_t) 1 << order), order);
+	}
+
+	/* 2의 거듭제곱이 아닌 요청이라면 남는 뒷부분을 돌려줌 */
+	if (page_cnt < (size_t) 1 << want)
+		buddy_free (p, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+
+	ASSERT (bitmap_none (p->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, true);
+	return page_idx;
+}
+
+/* 풀 P의 PAGE_IDX부터 PAGE_CNT개의 페이지를 빈 블록으로 돌려놓음. */
+/* 구간을 정렬된 가장 큰 블록들로 나눠서 넣음. P의 락을 잡고 있어야 함 */
+static void
+buddy_free (struct pool *p, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order + 1 < ORDER_CNT
+				&& page_idx % ((size_t) 1 << (order + 1)) == 0
+				&& ((size_t) 1 << (order + 1)) <= page_cnt)
+			order++;
+
+		buddy_insert (p, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* 풀 P의 PAGE_IDX에서 시작하는 ORDER 차수의 블록을 빈 블록으로 넣음. */
+/* 짝 블록도 비어있다면 합쳐서 한 차수 위로 올리기를 반복함 */
+static void
+buddy_insert (struct pool *p, size_t page_idx, int order) {
+	struct free_block *b;
+
+	while (order + 1 < ORDER_CNT) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > p->page_cnt
+				|| p->order_map[buddy] != order)
+			break;
+
+		buddy_remove (p, buddy, order);
+		if (buddy < page_idx)
+			page_idx = buddy;
+		order++;
+	}
+
+	b = (struct free_block *) (p->base + page_idx * PGSIZE);
+	list_push_front (&p->free_lists[order], &b->elem);
+	p->order_map[page_idx] = order;
+	p->free_cnt += (size_t) 1 << order;
+}
+
+/* 풀 P의 PAGE_IDX에서 시작하는 ORDER 차수의 빈 블록을 리스트에서 뺌 */
+static void
+buddy_remove (struct pool *p, size_t page_idx, int order) {
+	struct free_block *b = (struct free_block *) (p->base + page_idx * PGSIZE);
+
+	ASSERT (p->order_map[page_idx] == order);
+	list_remove (&b->elem);
+	p->order_map[page_idx] = ORDER_NONE;
+	p->free_cnt -= (size_t) 1 << order;
+}
+
+/* PAGE_CNT개의 페이지를 담을 수 있는 가장 작은 블록의 차수 */
+static int
+order_for (size_t page_cnt) {
+	int order = 0;
+
+	while (order < ORDER_CNT && ((size_t) 1 << order) < page_cnt)
+		order++;
+	return order;
+}
+
+/* 이 CPU의 풀 P 캐시에서 페이지를 하나 꺼내 반환. 캐시가 비었다면 풀에서 */
+/* PCP_BATCH개까지 채움. 풀에도 없다면 NULL */
+static void *
+pcp_get (struct pool *p) {
+	enum intr_level old_level = intr_disable ();
+	struct cpu_pages *pc = &cpu_pages[this_cpu ()->id][p == &user_pool];
+	void *page = NULL;
+
+	spin_lock (&pc->lock);
+	if (pc->cnt == 0) {
+		spin_lock (&p->lock);
+		while (pc->cnt < PCP_BATCH) {
+			size_t page_idx = buddy_alloc (p, 1);
+
+			if (page_idx == BITMAP_ERROR)
+				break;
+			pc->pages[pc->cnt] = p->base + PGSIZE * page_idx;
+			cache_mark (p, pc->pages[pc->cnt++], true);
+		}
+		spin_unlock (&p->lock);
+	}
+	if (pc->cnt > 0) {
+		page = pc->pages[--pc->cnt];
+		cache_mark (p, page, false);
+	}
+	spin_unlock (&pc->lock);
+	intr_set_level (old_level);
+
+	return page;
+}
+
+/* 풀 P의 페이지 PAGE를 이 CPU의 캐시에 넣음. 캐시가 가득 찼다면 */
+/* 오래된 PCP_BATCH개를 풀에 돌려보냄 */
+static void
+pcp_put (struct pool *p, void *page) {
+	enum intr_level old_level = intr_disable ();
+	struct cpu_pages *pc = &cpu_pages[this_cpu ()->id][p == &user_pool];
+
+	/* 이미 어떤 CPU의 캐시에 들어있다면 두 번 해제한 것 */
+	cache_mark (p, page, true);
+
+	spin_lock (&pc->lock);
+	if (pc->cnt == PCP_HIGH) {
+		spin_lock (&p->lock);
+		for (size_t i = 0; i < PCP_BATCH; i++) {
+			size_t page_idx = pg_no (pc->pages[i]) - pg_no (p->base);
+
+			cache_mark (p, pc->pages[i], false);
+			bitmap_reset (p->used_map, page_idx);
+			buddy_free (p, page_idx, 1);
+		}
+		spin_unlock (&p->lock);
+		pc->cnt -= PCP_BATCH;
+		memmove (pc->pages, pc->pages + PCP_BATCH, pc->cnt * sizeof *pc->pages);
+	}
+	pc->pages[pc->cnt++] = page;
+	spin_unlock (&pc->lock);
+	intr_set_level (old_level);
+}
+
+/* 모든 CPU의 풀 P 캐시를 비워서 페이지를 풀에 돌려보냄 */
+static void
+pcp_drain_all (struct pool *p) {
+	for (int i = 0; i < CPU_MAX; i++) {
+		struct cpu_pages *pc = &cpu_pages[i][p == &user_pool];
+		enum intr_level old_level = spin_lock_irqsave (&pc->lock);
+
+		spin_lock (&p->lock);
+		while (pc->cnt > 0) {
+			size_t page_idx = pg_no (pc->pages[--pc->cnt]) - pg_no (p->base);
+
+			cache_mark (p, pc->pages[pc->cnt], false);
+			bitmap_reset (p->used_map, page_idx);
+			buddy_free (p, page_idx, 1);
+		}
+		spin_unlock (&p->lock);
+		spin_unlock_irqrestore (&pc->lock, old_level);
+	}
+}
+
+/* 풀 P의 페이지 PAGE가 CPU별 캐시나 zero_list에 들어가거나(CACHED가 */
+/* true) 나옴을 디버그 빌드의 cache_map에 기록. 이미 그 상태라면 잘못 */
+/* 해제한 것. 여러 CPU가 풀의 락 없이 부르므로 원자적인 bitmap_mark()와 */
+/* bitmap_reset()만 씀 */
+static void
+cache_mark (struct pool *p UNUSED, void *page UNUSED, bool cached UNUSED) {
+#ifndef NDEBUG
+	size_t page_idx = pg_no (page) - pg_no (p->base);
+
+	ASSERT (bitmap_test (p->cache_map, page_idx) != cached);
+	if (cached)
+		bitmap_mark (p->cache_map, page_idx);
+	else
+		bitmap_reset (p->cache_map, page_idx);
+#endif
+}
+
+/* 풀 P의 미리 0으로 채운 페이지를 하나 꺼내 반환. 없다면 NULL */
+static void *
+zero_get (struct pool *p) {
+	struct free_block *b = NULL;
+	enum intr_level old_level = spin_lock_irqsave (&p->zero_lock);
+
+	if (!list_empty (&p->zero_list)) {
+		b = list_entry (list_pop_front (&p->zero_list), struct free_block, elem);
+		p->zero_cnt--;
+		cache_mark (p, b, false);
+	}
+	spin_unlock_irqrestore (&p->zero_lock, old_level);
+
+	if (b != NULL)
+		memset (b, 0, sizeof *b);
+	return b;
+}
+
+/* 풀 P의 zero_list가 가득 차지 않았다면 페이지를 하나 0으로 채워서 넣음. */
+/* 채웠다면 true */
+static bool
+zero_fill (struct pool *p) {
+	enum intr_level old_level;
+	struct free_block *b;
+	size_t page_idx;
+
+	/* 락 없이 먼저 봐서 가득 찬 동안에는 풀의 락을 건드리지 않음 */
+	if (p->zero_cnt >= ZERO_HIGH)
+		return false;
+
+	old_level = spin_lock_irqsave (&p->lock);
+	page_idx = buddy_alloc (p, 1);
+	spin_unlock_irqrestore (&p->lock, old_level);
+	if (page_idx == BITMAP_ERROR)
+		return false;
+
+	/* 인터럽트를 켠 채로 채우므로 그 사이 스레드가 깨어나면 바로 선점됨 */
+	b = (struct free_block *) (p->base + PGSIZE * page_idx);
+	memset (b, 0, PGSIZE);
+
+	old_level = spin_lock_irqsave (&p->zero_lock);
+	cache_mark (p, b, true);
+	list_push_front (&p->zero_list, &b->elem);
+	p->zero_cnt++;
+	spin_unlock_irqrestore (&p->zero_lock, old_level);
+	return true;
+}
+
+/* 풀 P의 미리 0으로 채운 페이지를 모두 풀에 돌려보냄 */
+static void
+zero_drain (struct pool *p) {
+	enum intr_level old_level = spin_lock_irqsave (&p->zero_lock);
+
+	spin_lock (&p->lock);
+	while (!list_empty (&p->zero_list)) {
+		void *page = list_pop_front (&p->zero_list);
+		size_t page_idx = pg_no (page) - pg_no (p->base);
+
+		cache_mark (p, page, false);
+		bitmap_reset (p->used_map, page_idx);
+		buddy_free (p, page_idx, 1);
+	}
+	p->zero_cnt = 0;
+	spin_unlock (&p->lock);
+	spin_unlock_irqrestore (&p->zero_lock, old_level);
+}
+
+/* idle 스레드에서 부름. 미리 0으로 채운 페이지가 모자란 풀이 있다면 */
+/* 한 페이지를 채우고 true를 반환. 모두 가득 찼다면 false */
+bool
+palloc_prezero (void) {
+	/* 익명 페이지 폴트가 쓰는 유저 풀을 먼저 채움 */
+	return zero_fill (&user_pool) || zero_fill (&kernel_pool);
+}
+
+/* 풀 P의 빈 페이지 수와 가장 큰 빈 블록 출력 */
+static void
+print_pool_stats (struct pool *p, const char *name) {
+	size_t cached = 0;
+
+	for (int i = 0; i < CPU_MAX; i++)
+		cached += cpu_pages[i][p == &user_pool].cnt;
+
+	enum intr_level old_level = spin_lock_irqsave (&p->lock);
+	size_t free_cnt = p->free_cnt;
+	int largest = -1;
+
+	for (int order = ORDER_CNT - 1; order >= 0; order--)
+		if (!list_empty (&p->free_lists[order])) {
+			largest = order;
+			break;
+		}
+	spin_unlock_irqrestore (&p->lock, old_level);
+
+	printf ("Palloc %s: %zu of %zu pages free, %zu cached per-CPU, "
+			"%zu pre-zeroed, largest free block %zu pages\n", name, free_cnt,
+			p->page_cnt, cached, p->zero_cnt,
+			largest >= 0 ? (size_t) 1 << largest : 0);
+}
+
+/* 두 풀의 단편화 상태 출력 */
+void
+palloc_print_stats (void) {
+	print_pool_stats (&kernel_pool, "kernel");
+	print_pool_stats (&user_pool, "user");
+}
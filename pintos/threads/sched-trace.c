@@ -0,0 +1,178 @@
+#include "threads/sched-trace.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/spinlock.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* 스케줄러 지연 추적.
+
+   thread_unblock()과 thread_yield()가 스레드를 준비 큐에 넣을 때,
+   그리고 schedule()이 스레드를 전환할 때마다 TSC를 읽어서 스레드별
+   히스토그램에 기록함. thread_block()으로 잠드는 스레드의 실행 구간은
+   뒤따르는 schedule()에서 끝남.
+   꺼져 있을 때는 스레드에 기록이 붙지 않으므로 NULL 확인만 함. */
+
+bool sched_trace_enabled;
+
+/* 만들어진 모든 기록을 만든 순서대로 이은 리스트. */
+static struct sched_trace *traces;
+static struct sched_trace **traces_tail = &traces;
+static struct spinlock traces_lock = { .name = "sched-trace" };
+
+static void hist_add (uint32_t *hist, uint64_t cycles);
+static void hist_print (const char *what, const uint32_t *hist);
+
+/* 추적이 켜져 있다면 스레드 T에 기록을 붙임. */
+/* T의 tid와 이름이 정해진 뒤, 처음 실행되기 전에 호출 */
+void
+sched_trace_attach (struct thread *t) {
+	/* 맨 처음 붙는 스레드는 malloc_init()보다 먼저 만들어지는 main 스레드 */
+	static struct sched_trace boot_trace;
+	static bool boot_used;
+	struct sched_trace *tr;
+	enum intr_level old_level;
+
+	if (!sched_trace_enabled)
+	{
+		return;
+	}
+
+	if (!boot_used)
+	{
+		boot_used = true;
+		tr = &boot_trace;
+	}
+	else
+	{
+		tr = malloc (sizeof *tr);
+		if (NULL == tr)
+		{
+			return;
+		}
+	}
+
+	memset (tr, 0, sizeof *tr);
+	tr->tid = t->tid;
+	strlcpy (tr->name, t->name, sizeof tr->name);
+
+	old_level = spin_lock_irqsave (&traces_lock);
+	*traces_tail = tr;
+	traces_tail = &tr->next;
+	spin_unlock_irqrestore (&traces_lock, old_level);
+
+	t->trace = tr;
+}
+
+/* 스레드 T가 준비 큐에 들어감. sched_lock을 잡고 있어야 함 */
+void
+sched_trace_ready (struct thread *t) {
+	if (NULL != t->trace)
+	{
+		t->trace->ready_at = rdtsc ();
+	}
+}
+
+/* PREV에서 NEXT로 전환함. 같은 스레드일 수도 있음. */
+/* sched_lock을 잡고 있어야 함 */
+void
+sched_trace_switch (struct thread *prev, struct thread *next) {
+	uint64_t now;
+
+	if ((NULL == prev->trace) && (NULL == next->trace))
+	{
+		return;
+	}
+
+	now = rdtsc ();
+	if ((prev != next) && (NULL != prev->trace) && (0 != prev->trace->run_at))
+	{
+		hist_add (prev->trace->run_hist, now - prev->trace->run_at);
+	}
+
+	if (NULL != next->trace)
+	{
+		/* idle 스레드처럼 준비 큐를 거치지 않은 스레드는 대기 시간이 없음 */
+		if (0 != next->trace->ready_at)
+		{
+			hist_add (next->trace->wait_hist, now - next->trace->ready_at);
+			next->trace->ready_at = 0;
+		}
+		if (prev != next)
+		{
+			next->trace->run_at = now;
+		}
+	}
+}
+
+/* 지금까지 모인 모든 스레드의 히스토그램을 출력 */
+void
+sched_trace_print (void) {
+	if (!sched_trace_enabled)
+	{
+		return;
+	}
+
+	printf ("Scheduler trace (log2 TSC cycles):\n");
+	for (struct sched_trace *tr = traces; NULL != tr; tr = tr->next)
+	{
+		printf ("Thread %d (%s):\n", tr->tid, tr->name);
+		hist_print ("wait", tr->wait_hist);
+		hist_print ("run", tr->run_hist);
+	}
+}
+
+/* HIST에서 CYCLES가 들어갈 칸을 하나 늘림 */
+static void
+hist_add (uint32_t *hist, uint64_t cycles) {
+	int bucket = (0 == cycles) ? 0 : 63 - __builtin_clzll (cycles);
+
+	if (SCHED_TRACE_BUCKETS <= bucket)
+	{
+		bucket = SCHED_TRACE_BUCKETS - 1;
+	}
+	hist[bucket]++;
+}
+
+/* 히스토그램 HIST를 WHAT이라는 이름으로 한 줄에 출력. */
+/* 비어있지 않은 칸과 함께, 꼬리 지연을 보기 위해 중앙값과 99번째 */
+/* 백분위수가 들어있는 칸의 상한을 보여줌 */
+static void
+hist_print (const char *what, const uint32_t *hist) {
+	uint64_t total = 0, seen = 0;
+	int p50 = -1, p99 = -1;
+
+	for (int i = 0; i < SCHED_TRACE_BUCKETS; ++i)
+	{
+		total += hist[i];
+	}
+	if (0 == total)
+	{
+		return;
+	}
+
+	for (int i = 0; i < SCHED_TRACE_BUCKETS; ++i)
+	{
+		seen += hist[i];
+		if ((0 > p50) && (seen * 2 >= total))
+		{
+			p50 = i;
+		}
+		if ((0 > p99) && (seen * 100 >= total * 99))
+		{
+			p99 = i;
+		}
+	}
+
+	printf ("  %-4s n=%llu p50<2^%d p99<2^%d:", what, total, p50 + 1, p99 + 1);
+	for (int i = 0; i < SCHED_TRACE_BUCKETS; ++i)
+	{
+		if (0 != hist[i])
+		{
+			printf (" %d:%u", i, hist[i]);
+		}
+	}
+	printf ("\n");
+}
@@ -0,0 +1,282 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/cpu.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* 슬랩 할당자.
+
+   슬랩은 페이지 하나이며 맨 앞에 struct slab이 있고, 그 뒤에 빈 객체의
+   연결 리스트를 이루는 색인 배열, 그 뒤에 객체들이 옴. 빈 객체를 객체
+   안이 아닌 색인 배열로 이으므로 생성자가 만든 상태가 깨지지 않음.
+   객체로부터 슬랩은 페이지 경계로 내려서 찾음.
+
+   객체를 다 채우고 남는 공간은 캐시 색칠에 씀. 슬랩마다 첫 객체의 위치를
+   캐시 라인 단위로 조금씩 밀어서, 여러 슬랩의 같은 번호 객체가 같은
+   캐시 세트로 몰리지 않도록 함.
+
+   캐시마다 빈 슬랩은 하나만 남겨두고 나머지는 바로 페이지 할당자에게
+   돌려줌. 락 순서: 캐시의 락 -> palloc의 락 */
+
+/* 슬랩 손상을 찾기 위한 값. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* 색인 배열에서 리스트의 끝. */
+#define SLAB_END UINT16_MAX
+
+/* 슬랩 머리. */
+struct slab {
+	unsigned magic;             /* 항상 SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* 이 슬랩을 가진 캐시. */
+	struct list_elem elem;      /* 캐시의 partial, full, empty 리스트 원소. */
+	uint8_t *objs;              /* 첫 객체. */
+	size_t inuse;               /* 할당된 객체 수. */
+	uint16_t free;              /* 첫 빈 객체의 번호, 없다면 SLAB_END. */
+	uint16_t next[];            /* next[i]는 빈 객체 i 다음의 빈 객체 번호. */
+};
+
+/* 모든 캐시를 만든 순서대로 이은 리스트. */
+static struct kmem_cache *caches;
+static struct kmem_cache **caches_tail = &caches;
+static struct spinlock caches_lock = { .name = "kmem_caches" };
+
+static size_t slab_objs_ofs (size_t obj_cnt, size_t align);
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+
+/* SIZE바이트 객체를 ALIGN바이트 경계에 담는 캐시 NAME을 만듦.
+   ALIGN은 0(포인터 크기)이거나 2의 거듭제곱이어야 함. CTOR가 NULL이 아니면
+   슬랩을 만들 때 객체마다 호출함. 메모리가 없다면 NULL.
+   NAME은 통계를 출력할 때까지 남아있어야 함. malloc_init() 뒤에 호출 */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c;
+	size_t obj_cnt, left;
+	enum intr_level old_level;
+
+	ASSERT (name != NULL);
+	ASSERT (0 < size);
+
+	if (0 == align)
+	{
+		align = sizeof (void *);
+	}
+	ASSERT (0 == (align & (align - 1)));
+
+	/* 머리와 색인 배열까지 넣어서 객체가 하나도 안 들어가는 크기는 받지 않음 */
+	size = ROUND_UP (size, align);
+	obj_cnt = (PGSIZE - sizeof (struct slab)) / (size + sizeof (uint16_t));
+	while ((0 < obj_cnt) && (PGSIZE < slab_objs_ofs (obj_cnt, align) + obj_cnt * size))
+	{
+		obj_cnt--;
+	}
+	ASSERT (0 < obj_cnt);
+
+	c = malloc (sizeof *c);
+	if (NULL == c)
+	{
+		return NULL;
+	}
+
+	c->name = name;
+	c->obj_size = size;
+	c->align = align;
+	c->objs_per_slab = obj_cnt;
+	c->first_ofs = slab_objs_ofs (obj_cnt, align);
+	c->ctor = ctor;
+
+	/* 남는 공간을 캐시 라인 단위(정렬이 더 크다면 정렬 단위)로 나눈 만큼 색이 있음 */
+	left = PGSIZE - c->first_ofs - obj_cnt * size;
+	c->colour_cnt = left / (align > CACHE_LINE_SIZE ? align : CACHE_LINE_SIZE) + 1;
+	c->colour_next = 0;
+
+	spinlock_init (&c->lock, name);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	c->slab_cnt = 0;
+	c->inuse_cnt = 0;
+	c->peak_cnt = 0;
+
+	c->next = NULL;
+	old_level = spin_lock_irqsave (&caches_lock);
+	*caches_tail = c;
+	caches_tail = &c->next;
+	spin_unlock_irqrestore (&caches_lock, old_level);
+
+	return c;
+}
+
+/* 캐시 C에서 객체를 하나 할당해서 반환. 메모리가 없다면 NULL. */
+/* 생성자가 있다면 생성자가 만든 상태로 돌려줌 */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+	enum intr_level old_level;
+
+	ASSERT (c != NULL);
+
+	old_level = spin_lock_irqsave (&c->lock);
+
+	/* 일부만 쓰는 슬랩을 먼저 채워서 빈 슬랩이 생기도록 함 */
+	if (!list_empty (&c->partial))
+	{
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	}
+	else if (!list_empty (&c->empty))
+	{
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	else
+	{
+		s = slab_create (c);
+		if (NULL == s)
+		{
+			spin_unlock_irqrestore (&c->lock, old_level);
+			return NULL;
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	ASSERT (SLAB_END != s->free);
+	obj = s->objs + s->free * c->obj_size;
+	s->free = s->next[s->free];
+	if (c->objs_per_slab == ++s->inuse)
+	{
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+
+	if (c->peak_cnt < ++c->inuse_cnt)
+	{
+		c->peak_cnt = c->inuse_cnt;
+	}
+
+	spin_unlock_irqrestore (&c->lock, old_level);
+	return obj;
+}
+
+/* 캐시 C에서 할당한 객체 OBJ를 돌려줌. NULL이라면 아무것도 하지 않음 */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+	struct slab *release = NULL;
+	size_t idx;
+	enum intr_level old_level;
+
+	if (NULL == obj)
+	{
+		return;
+	}
+
+	s = obj_to_slab (c, obj);
+	idx = ((uint8_t *) obj - s->objs) / c->obj_size;
+
+	old_level = spin_lock_irqsave (&c->lock);
+
+	ASSERT (0 < s->inuse);
+	s->next[idx] = s->free;
+	s->free = idx;
+	c->inuse_cnt--;
+
+	/* 가득 찼던 슬랩은 partial로, 다 비었다면 empty로 옮김. */
+	/* 빈 슬랩이 이미 하나 있다면 이 슬랩은 페이지 할당자에게 돌려줌 */
+	if (c->objs_per_slab == s->inuse--)
+	{
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	if (0 == s->inuse)
+	{
+		list_remove (&s->elem);
+		if (list_empty (&c->empty))
+		{
+			list_push_front (&c->empty, &s->elem);
+		}
+		else
+		{
+			c->slab_cnt--;
+			release = s;
+		}
+	}
+
+	spin_unlock_irqrestore (&c->lock, old_level);
+
+	if (NULL != release)
+	{
+		release->magic = 0;
+		palloc_free_page (release);
+	}
+}
+
+/* 모든 캐시의 사용량 출력 */
+void
+kmem_print_stats (void) {
+	for (struct kmem_cache *c = caches; NULL != c; c = c->next)
+	{
+		printf ("Slab %s: %zu-byte objects, %zu per page, %zu in use "
+				"(peak %zu), %zu pages\n", c->name, c->obj_size,
+				c->objs_per_slab, c->inuse_cnt, c->peak_cnt, c->slab_cnt);
+	}
+}
+
+/* 객체 OBJ_CNT개짜리 슬랩에서 색칠하기 전 첫 객체의 오프셋. */
+/* 머리와 색인 배열 뒤를 ALIGN으로 올림 */
+static size_t
+slab_objs_ofs (size_t obj_cnt, size_t align) {
+	return ROUND_UP (sizeof (struct slab) + obj_cnt * sizeof (uint16_t), align);
+}
+
+/* 캐시 C의 새 슬랩을 만들고 객체마다 생성자를 호출. 페이지가 없다면 NULL. */
+/* C의 락을 잡고 있어야 함 */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	size_t step = c->align > CACHE_LINE_SIZE ? c->align : CACHE_LINE_SIZE;
+	struct slab *s;
+
+	ASSERT (spin_held (&c->lock));
+
+	s = palloc_get_page (0);
+	if (NULL == s)
+	{
+		return NULL;
+	}
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->objs = (uint8_t *) s + c->first_ofs + c->colour_next * step;
+	s->inuse = 0;
+	c->colour_next = (c->colour_next + 1) % c->colour_cnt;
+
+	s->free = 0;
+	for (size_t i = 0; i < c->objs_per_slab; i++)
+	{
+		s->next[i] = (i + 1 < c->objs_per_slab) ? i + 1 : SLAB_END;
+		if (NULL != c->ctor)
+		{
+			c->ctor (s->objs + i * c->obj_size);
+		}
+	}
+
+	c->slab_cnt++;
+	return s;
+}
+
+/* 캐시 C의 객체 OBJ가 들어있는 슬랩을 반환 */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+	ASSERT (((uint8_t *) obj - s->objs) % c->obj_size == 0);
+
+	return s;
+}
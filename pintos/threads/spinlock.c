@@ -0,0 +1,108 @@
+#include "threads/spinlock.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/cpu.h"
+
+/* 스핀락 L을 NAME이라는 이름으로 초기화 */
+void
+spinlock_init (struct spinlock *l, const char *name) {
+	ASSERT (l != NULL);
+
+	l->locked = 0;
+	l->holder = NULL;
+	l->name = name;
+	l->stat = NULL;
+}
+
+/* 스핀락 L의 경쟁 프로파일을 STAT에 기록하기 시작함 */
+void
+spinlock_profile (struct spinlock *l, struct lock_stat *stat) {
+	ASSERT (l != NULL);
+
+	l->stat = stat;
+}
+
+/* 스핀락 L을 잡을 때까지 돌며 기다림. 인터럽트가 꺼져 있어야 함. */
+/* 같은 CPU에서 이미 잡고 있는 락을 다시 잡으면 교착되므로 재귀 호출은 금지 */
+void
+spin_lock (struct spinlock *l) {
+	ASSERT (l != NULL);
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!spin_held (l));
+
+	bool contended = false;
+
+	/* 잡혀 있는 동안에는 xchg 대신 읽기만 하며 기다려서 */
+	/* 캐시 라인이 CPU 사이를 계속 오가지 않도록 함 */
+	while (0 != __atomic_exchange_n (&l->locked, 1, __ATOMIC_ACQUIRE))
+	{
+		contended = true;
+		while (0 != l->locked)
+		{
+			cpu_relax ();
+		}
+	}
+
+	l->holder = this_cpu ();
+	if (NULL != l->stat)
+	{
+		lock_stat_acquired (l->stat, contended, contended);
+	}
+}
+
+/* 스핀락 L을 기다리지 않고 잡아봄. 잡았다면 true 반환. */
+/* 인터럽트가 꺼져 있어야 함 */
+bool
+spin_trylock (struct spinlock *l) {
+	ASSERT (l != NULL);
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (0 != __atomic_exchange_n (&l->locked, 1, __ATOMIC_ACQUIRE))
+	{
+		return false;
+	}
+
+	l->holder = this_cpu ();
+	if (NULL != l->stat)
+	{
+		lock_stat_acquired (l->stat, false, false);
+	}
+	return true;
+}
+
+/* 현재 CPU가 잡고 있는 스핀락 L을 놓음 */
+void
+spin_unlock (struct spinlock *l) {
+	ASSERT (l != NULL);
+	ASSERT (spin_held (l));
+
+	if (NULL != l->stat)
+	{
+		lock_stat_released (l->stat);
+	}
+	l->holder = NULL;
+	__atomic_store_n (&l->locked, 0, __ATOMIC_RELEASE);
+}
+
+/* 현재 CPU가 스핀락 L을 잡고 있다면 true. */
+/* 다른 CPU가 잡고 있는지 확인하는 용도로는 쓸 수 없음 */
+bool
+spin_held (const struct spinlock *l) {
+	return (0 != l->locked) && (this_cpu () == l->holder);
+}
+
+/* 인터럽트를 끄고 스핀락 L을 잡음. 이전 인터럽트 상태를 반환 */
+enum intr_level
+spin_lock_irqsave (struct spinlock *l) {
+	enum intr_level old_level = intr_disable ();
+
+	spin_lock (l);
+	return old_level;
+}
+
+/* 스핀락 L을 놓고 인터럽트 상태를 OLD_LEVEL로 되돌림 */
+void
+spin_unlock_irqrestore (struct spinlock *l, enum intr_level old_level) {
+	spin_unlock (l);
+	intr_set_level (old_level);
+}
@@ -29,9 +29,20 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "devices/timeout.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+/* 스레드 A의 순위가 B보다 낮다면 true. list_max()에 사용 */
+static bool
+thread_priority_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = list_entry (a_, struct thread, elem);
+	const struct thread *b = list_entry (b_, struct thread, elem);
+
+	return thread_rank (a) < thread_rank (b);
+}
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -47,6 +58,30 @@ sema_init (struct semaphore *sema, unsigned value) {
 
 	sema->value = value;
 	list_init (&sema->waiters);
+	spinlock_init (&sema->lock, "sema");
+}
+
+/* SEMA를 기다리는 스레드 중 우선순위가 가장 높은 스레드를 깨워 반환. */
+/* 기다리는 스레드가 없다면 NULL. SEMA의 스핀락을 잡고 있어야 함 */
+static struct thread *
+sema_wake_one (struct semaphore *sema) {
+	struct list_elem *e;
+	struct thread *t;
+
+	ASSERT (spin_held (&sema->lock));
+
+	if (list_empty (&sema->waiters))
+	{
+		return NULL;
+	}
+
+	/* 대기 중에도 기부로 우선순위가 바뀔 수 있으므로 깨울 때 가장 높은 스레드를 찾음 */
+	e = list_max (&sema->waiters, thread_priority_less, NULL);
+	list_remove (e);
+	t = list_entry (e, struct thread, elem);
+	thread_unblock (t);
+
+	return t;
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -64,13 +99,101 @@ sema_down (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 	ASSERT (!intr_context ());
 
-	old_level = intr_disable ();
+	old_level = spin_lock_irqsave (&sema->lock);
 	while (sema->value == 0) {
 		list_push_back (&sema->waiters, &thread_current ()->elem);
-		thread_block ();
+		/* 잠든 뒤에 락을 놓으므로 그 사이에 끼어든 sema_up()을 놓치지 않음 */
+		thread_block_unlock (&sema->lock);
+		spin_lock (&sema->lock);
 	}
 	sema->value--;
+	spin_unlock_irqrestore (&sema->lock, old_level);
+}
+
+/* sema_down_timeout()으로 대기 중인 스레드 정보. 대기하는 스레드의 스택에 둠 */
+struct sema_timeout_waiter {
+	struct thread *thread;              /* 대기 중인 스레드. */
+	struct semaphore *sema;             /* 기다리는 세마포어. */
+	bool expired;                       /* 타임아웃이 만료되었는지 여부. */
+};
+
+/* sema_down_timeout()의 타임아웃 콜백. 타이머 인터럽트 안에서 실행됨. */
+/* 스레드가 아직 세마포어에서 대기 중이라면 대기 리스트에서 빼내 깨움 */
+static void
+sema_timeout_expire (void *aux) {
+	struct sema_timeout_waiter *w = aux;
+	struct semaphore *sema = w->sema;
+	struct thread *t = w->thread;
+
+	spin_lock (&sema->lock);
+	w->expired = true;
+
+	/* 이미 sema_up()으로 깨어난 상태라면 스레드가 직접 값을 다시 확인함. */
+	/* 다른 CPU에서 막 잠들려는 중일 수 있으므로 상태 대신 리스트를 봄 */
+	for (struct list_elem *e = list_begin (&sema->waiters);
+			e != list_end (&sema->waiters); e = list_next (e))
+	{
+		if (e == &t->elem)
+		{
+			list_remove (e);
+			thread_unblock (t);
+			if (thread_should_preempt (t))
+			{
+				thread_preempt ();
+			}
+			break;
+		}
+	}
+	spin_unlock (&sema->lock);
+}
+
+/* sema_down()과 같지만 최대 TICKS tick까지만 대기함. */
+/* 세마포어를 내렸다면 true, 시간 안에 값이 양수가 되지 않았다면 false 반환. */
+/* TICKS가 0 이하라면 sema_try_down()과 같음. */
+/* 잠들 수 있으므로 인터럽트 핸들러 안에서 호출하면 안 됨. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks) {
+	struct sema_timeout_waiter w;
+	struct timeout timeout;
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	if (0 >= ticks)
+	{
+		return sema_try_down (sema);
+	}
+
+	w.thread = thread_current ();
+	w.sema = sema;
+	w.expired = false;
+	timeout_init (&timeout, sema_timeout_expire, &w);
+
+	old_level = intr_disable ();
+	timeout_arm (&timeout, ticks);
+	spin_lock (&sema->lock);
+	while ((0 == sema->value) && !w.expired) {
+		list_push_back (&sema->waiters, &thread_current ()->elem);
+		thread_block_unlock (&sema->lock);
+		spin_lock (&sema->lock);
+	}
+
+	/* 타임아웃과 sema_up()이 동시에 일어났다면 값이 있는 쪽을 우선함 */
+	success = (0 < sema->value);
+	if (success)
+	{
+		sema->value--;
+	}
+	spin_unlock (&sema->lock);
+
+	/* 타임아웃은 스택에 있으므로 반환 전에 반드시 취소. */
+	/* 콜백이 세마포어의 락을 잡으므로 락을 놓은 뒤에 취소해야 함 */
+	timeout_cancel (&timeout);
 	intr_set_level (old_level);
+
+	return success;
 }
 
 /* Down or "P" operation on a semaphore, but only if the
@@ -85,7 +208,7 @@ sema_try_down (struct semaphore *sema) {
 
 	ASSERT (sema != NULL);
 
-	old_level = intr_disable ();
+	old_level = spin_lock_irqsave (&sema->lock);
 	if (sema->value > 0)
 	{
 		sema->value--;
@@ -93,7 +216,7 @@ sema_try_down (struct semaphore *sema) {
 	}
 	else
 		success = false;
-	intr_set_level (old_level);
+	spin_unlock_irqrestore (&sema->lock, old_level);
 
 	return success;
 }
@@ -108,12 +231,20 @@ sema_up (struct semaphore *sema) {
 
 	ASSERT (sema != NULL);
 
-	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters))
-		thread_unblock (list_entry (list_pop_front (&sema->waiters),
-					struct thread, elem));
+	struct thread *woken;
+	bool preempt;
+
+	old_level = spin_lock_irqsave (&sema->lock);
+	woken = sema_wake_one (sema);
 	sema->value++;
-	intr_set_level (old_level);
+	preempt = (NULL != woken) && thread_should_preempt (woken);
+	spin_unlock_irqrestore (&sema->lock, old_level);
+
+	/* 깨운 스레드의 우선순위가 더 높다면 양보. 스핀락을 놓은 뒤에 해야 함 */
+	if (preempt)
+	{
+		thread_preempt ();
+	}
 }
 
 static void sema_test_helper (void *sema_);
@@ -166,14 +297,35 @@ sema_test_helper (void *sema_) {
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
+/* 우선순위 기부를 따라 올라가는 최대 깊이. */
+/* 커널 명령줄 옵션 "-donate-depth=N"으로 바꿀 수 있음 */
+int lock_donation_depth = LOCK_DONATION_DEPTH;
+
+/* 잠들기 전에 점유자가 락을 풀기를 기다리며 도는 최대 횟수. */
+/* 커널 명령줄 옵션 "-lock-spin=N"으로 바꿀 수 있으며 0이면 돌지 않음 */
+int lock_spin_limit = LOCK_SPIN_LIMIT;
+
+static void lock_spin (struct lock *);
+static void lock_donate (struct thread *);
+static void lock_take_donors (struct lock *);
+
 void
 lock_init (struct lock *lock) {
 	ASSERT (lock != NULL);
 
 	lock->holder = NULL;
+	lock->stat = NULL;
 	sema_init (&lock->semaphore, 1);
 }
 
+/* LOCK의 경쟁 프로파일을 STAT에 기록하기 시작함 */
+void
+lock_profile (struct lock *lock, struct lock_stat *stat) {
+	ASSERT (lock != NULL);
+
+	lock->stat = stat;
+}
+
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
@@ -182,14 +334,128 @@ lock_init (struct lock *lock) {
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
    we need to sleep. */
+/* 점유자가 다른 CPU에서 실행 중이라면 곧 풀어줄 가능성이 높으므로, */
+/* 잠들고 깨어나는 비용을 치르기 전에 잠시 돌면서 기다려 봄 */
 void
 lock_acquire (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	sema_down (&lock->semaphore);
-	lock->holder = thread_current ();
+	struct thread *cur = thread_current ();
+	struct semaphore *sema = &lock->semaphore;
+	enum intr_level old_level;
+	bool contended = false;
+	bool slept = false;
+
+	old_level = spin_lock_irqsave (&sema->lock);
+	if (0 == sema->value)
+	{
+		contended = true;
+		spin_unlock_irqrestore (&sema->lock, old_level);
+		lock_spin (lock);
+		old_level = spin_lock_irqsave (&sema->lock);
+	}
+
+	/* sema_down()을 풀어 쓴 것. 깨어난 사이에 다른 스레드가 락을 가로챘다면 */
+	/* 새 점유자에게 다시 기부해야 하므로 잠들 때마다 기부함 */
+	while (0 == sema->value)
+	{
+		/* 락이 이미 점유 중이라면 점유자에게 우선순위를 기부. MLFQS에서는 기부하지 않음 */
+		if (!thread_mlfqs && (NULL != lock->holder) && (NULL == cur->donee))
+		{
+			spin_lock (&sched_lock);
+			cur->wait_on_lock = lock;
+			cur->donee = lock->holder;
+			heap_push (&lock->holder->donors, &cur->donor_elem);
+			lock_donate (cur);
+			spin_unlock (&sched_lock);
+		}
+
+		list_push_back (&sema->waiters, &cur->elem);
+		slept = true;
+		thread_block_unlock (&sema->lock);
+		spin_lock (&sema->lock);
+	}
+	sema->value--;
+
+	cur->wait_on_lock = NULL;
+	lock->holder = cur;
+	lock_take_donors (lock);
+	if (NULL != lock->stat)
+	{
+		lock_stat_acquired (lock->stat, contended, contended && !slept);
+	}
+
+	spin_unlock_irqrestore (&sema->lock, old_level);
+}
+
+/* 점유자가 LOCK을 풀 때까지 최대 lock_spin_limit번 돌며 기다림. */
+/* 점유자가 실행 중이 아니라면(잠들었거나 이 CPU에서 밀려났다면) 곧 풀릴 */
+/* 가망이 없으므로 바로 그만둠. 단일 CPU에서는 점유자가 실행 중일 수 없으므로 */
+/* 돌지 않음 */
+static void
+lock_spin (struct lock *lock) {
+	for (int i = 0; i < lock_spin_limit; ++i)
+	{
+		struct thread *holder = __atomic_load_n (&lock->holder, __ATOMIC_ACQUIRE);
+
+		/* 점유자가 끝나서 구조체가 해제되었더라도 페이지는 커널에 매핑되어 */
+		/* 있으므로 읽기만 하는 것은 안전함 */
+		if ((NULL == holder) || (THREAD_RUNNING != holder->status))
+		{
+			return;
+		}
+		cpu_relax ();
+	}
+}
+
+/* 기부자 T의 우선순위를 T가 기다리는 락의 점유자에게 전파. */
+/* 점유자가 다른 락을 기다리고 있다면 그 락의 점유자에게도 이어서 전파하며 */
+/* 최대 lock_donation_depth 단계까지만 올라감. sched_lock을 잡고 있어야 함 */
+static void
+lock_donate (struct thread *t) {
+	for (int depth = 0; (depth < lock_donation_depth) && (NULL != t->donee); ++depth)
+	{
+		struct thread *holder = t->donee;
+
+		/* 점유자의 우선순위가 바뀌지 않았다면 더 위로 전파할 필요 없음 */
+		if (!thread_refresh_priority (holder))
+		{
+			break;
+		}
+
+		t = holder;
+	}
+}
+
+/* 방금 LOCK을 얻은 현재 스레드에게, 아직 LOCK을 기다리고 있는 스레드들이 */
+/* 기부하도록 등록함. 이전 점유자가 풀어줄 때 기부가 끊겼기 때문. */
+/* LOCK의 세마포어 락을 잡고 있어야 함 */
+static void
+lock_take_donors (struct lock *lock) {
+	struct thread *cur = thread_current ();
+	struct list *waiters = &lock->semaphore.waiters;
+
+	if (thread_mlfqs)
+	{
+		return;
+	}
+
+	spin_lock (&sched_lock);
+	for (struct list_elem *e = list_begin (waiters); e != list_end (waiters); e = list_next (e))
+	{
+		struct thread *t = list_entry (e, struct thread, elem);
+
+		if (NULL == t->donee)
+		{
+			t->donee = cur;
+			heap_push (&cur->donors, &t->donor_elem);
+		}
+	}
+
+	thread_refresh_priority (cur);
+	spin_unlock (&sched_lock);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -205,9 +471,20 @@ lock_try_acquire (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	success = sema_try_down (&lock->semaphore);
+	struct semaphore *sema = &lock->semaphore;
+	enum intr_level old_level = spin_lock_irqsave (&sema->lock);
+	success = 0 < sema->value;
 	if (success)
+	{
+		sema->value--;
 		lock->holder = thread_current ();
+		lock_take_donors (lock);
+		if (NULL != lock->stat)
+		{
+			lock_stat_acquired (lock->stat, false, false);
+		}
+	}
+	spin_unlock_irqrestore (&sema->lock, old_level);
 	return success;
 }
 
@@ -222,8 +499,46 @@ lock_release (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
+	struct thread *cur = thread_current ();
+	struct semaphore *sema = &lock->semaphore;
+	struct list *waiters = &sema->waiters;
+	enum intr_level old_level;
+	struct thread *woken;
+	bool preempt;
+
+	old_level = spin_lock_irqsave (&sema->lock);
+
+	/* 이 락을 기다리던 스레드들의 기부를 회수하고, 남은 기부자 중 */
+	/* 가장 높은 우선순위(힙의 top)로 현재 스레드의 우선순위를 다시 계산 */
+	spin_lock (&sched_lock);
+	for (struct list_elem *e = list_begin (waiters); e != list_end (waiters); e = list_next (e))
+	{
+		struct thread *t = list_entry (e, struct thread, elem);
+
+		if (cur == t->donee)
+		{
+			heap_remove (&cur->donors, &t->donor_elem);
+			t->donee = NULL;
+		}
+	}
+	thread_refresh_priority (cur);
+	spin_unlock (&sched_lock);
+
+	if (NULL != lock->stat)
+	{
+		lock_stat_released (lock->stat);
+	}
 	lock->holder = NULL;
-	sema_up (&lock->semaphore);
+	woken = sema_wake_one (sema);
+	sema->value++;
+	preempt = (NULL != woken) && thread_should_preempt (woken);
+
+	spin_unlock_irqrestore (&sema->lock, old_level);
+
+	if (preempt)
+	{
+		thread_preempt ();
+	}
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -240,8 +555,19 @@ lock_held_by_current_thread (const struct lock *lock) {
 struct semaphore_elem {
 	struct list_elem elem;              /* List element. */
 	struct semaphore semaphore;         /* This semaphore. */
+	struct thread *thread;              /* 기다리는 스레드. */
 };
 
+/* 조건 변수 대기자 A의 순위가 B보다 낮다면 true. list_max()에 사용 */
+static bool
+cond_waiter_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct semaphore_elem *a = list_entry (a_, struct semaphore_elem, elem);
+	const struct semaphore_elem *b = list_entry (b_, struct semaphore_elem, elem);
+
+	return thread_rank (a->thread) < thread_rank (b->thread);
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -282,12 +608,48 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	ASSERT (lock_held_by_current_thread (lock));
 
 	sema_init (&waiter.semaphore, 0);
+	waiter.thread = thread_current ();
 	list_push_back (&cond->waiters, &waiter.elem);
 	lock_release (lock);
 	sema_down (&waiter.semaphore);
 	lock_acquire (lock);
 }
 
+/* cond_wait()과 같지만 최대 TICKS tick까지만 신호를 기다림. */
+/* 신호를 받았다면 true, 시간이 초과되었다면 false 반환. */
+/* 어느 경우든 반환할 때는 LOCK을 다시 획득한 상태임. */
+bool
+cond_wait_timeout (struct condition *cond, struct lock *lock, int64_t ticks) {
+	struct semaphore_elem waiter;
+	bool signaled;
+
+	ASSERT (cond != NULL);
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
+
+	sema_init (&waiter.semaphore, 0);
+	waiter.thread = thread_current ();
+	list_push_back (&cond->waiters, &waiter.elem);
+	lock_release (lock);
+	signaled = sema_down_timeout (&waiter.semaphore, ticks);
+	lock_acquire (lock);
+
+	if (!signaled)
+	{
+		/* 타임아웃 직후 락을 다시 얻기 전에 신호가 왔을 수 있음. */
+		/* 신호를 보낸 쪽은 LOCK을 잡고 waiter를 리스트에서 뺀 뒤 sema_up 하므로, */
+		/* 세마포어 값이 있다면 신호를 받은 것이고 없다면 아직 리스트에 남아 있음 */
+		signaled = sema_try_down (&waiter.semaphore);
+		if (!signaled)
+		{
+			list_remove (&waiter.elem);
+		}
+	}
+
+	return signaled;
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -302,9 +664,14 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
+	/* 가장 높은 우선순위의 대기자부터 깨움 */
 	if (!list_empty (&cond->waiters))
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
+	{
+		struct list_elem *e = list_max (&cond->waiters, cond_waiter_less, NULL);
+
+		list_remove (e);
+		sema_up (&list_entry (e, struct semaphore_elem, elem)->semaphore);
+	}
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -321,3 +688,223 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	while (!list_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
+
+/* Initializes reader-writer lock RW.  Any number of threads may
+   hold RW for reading at once, but a thread holding it for
+   writing excludes all other readers and writers. */
+/* 쓰는 스레드를 우선함. 쓰려는 스레드가 하나라도 있으면 새로 오는 */
+/* 읽는 스레드는 GATE 락 뒤에 줄을 서므로, 읽는 스레드가 계속 들어와도 */
+/* 쓰는 스레드가 굶지 않음. 쓰는 스레드는 쓰는 내내 GATE를 잡고 있으므로 */
+/* 기다리는 스레드들의 우선순위는 일반 락과 똑같이 쓰는 스레드에게 기부됨. */
+/* 읽는 스레드가 빠지기를 기다리는 쓰는 스레드는 HOLDERS의 맨 앞 스레드에게 */
+/* 기부하고, 그 스레드가 빠지면 다음 스레드에게 기부를 넘겨줌 */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->gate);
+	spinlock_init (&rw->lock, "rwlock");
+	rw->readers = 0;
+	rw->writers = 0;
+	rw->drain_waiter = NULL;
+	list_init (&rw->holders);
+}
+
+/* T가 RW를 읽기 위해 잡은 기록을 찾음. RW가 NULL이면 빈 칸을 찾음. */
+/* 없으면 NULL */
+static struct rwlock_hold *
+rwlock_hold_find (struct thread *t, struct rwlock *rw) {
+	for (int i = 0; i < RWLOCK_HOLD_MAX; ++i)
+	{
+		if (rw == t->rw_holds[i].rw)
+		{
+			return &t->rw_holds[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* 현재 스레드를 RW의 읽는 스레드로 셈. RW의 스핀락을 잡고 있어야 함 */
+static void
+rwlock_add_reader (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	struct rwlock_hold *h = rwlock_hold_find (cur, rw);
+
+	rw->readers++;
+	if (NULL == h)
+	{
+		h = rwlock_hold_find (cur, NULL);
+		if (NULL == h)
+		{
+			return;
+		}
+		h->rw = rw;
+		h->thread = cur;
+		h->depth = 0;
+		list_push_back (&rw->holders, &h->elem);
+	}
+	h->depth++;
+}
+
+/* 읽는 스레드가 빠지기를 기다리는 WRITER가 RW를 읽고 있는 스레드 하나에게 */
+/* 우선순위를 기부하도록 함. 기부받은 스레드를 반환하며, 기록된 읽는 */
+/* 스레드가 없거나 MLFQS라면 NULL. RW의 스핀락을 잡고 있어야 함 */
+static struct thread *
+rwlock_donate (struct rwlock *rw, struct thread *writer) {
+	struct thread *reader;
+
+	ASSERT (NULL == writer->donee);
+
+	if (thread_mlfqs || list_empty (&rw->holders))
+	{
+		return NULL;
+	}
+
+	reader = list_entry (list_front (&rw->holders), struct rwlock_hold, elem)->thread;
+	spin_lock (&sched_lock);
+	writer->donee = reader;
+	heap_push (&reader->donors, &writer->donor_elem);
+	lock_donate (writer);
+	spin_unlock (&sched_lock);
+
+	return reader;
+}
+
+/* RW를 읽기 위해 얻음. 쓰는 스레드가 있다면 끝날 때까지 잠듦. */
+/* 잠들 수 있으므로 인터럽트 핸들러 안에서 호출하면 안 됨 */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!lock_held_by_current_thread (&rw->gate));
+
+	/* 쓰려는 스레드가 없다면 GATE를 거치지 않고 바로 읽기 시작 */
+	old_level = spin_lock_irqsave (&rw->lock);
+	if (0 == rw->writers)
+	{
+		rwlock_add_reader (rw);
+		spin_unlock_irqrestore (&rw->lock, old_level);
+		return;
+	}
+	spin_unlock_irqrestore (&rw->lock, old_level);
+
+	/* 먼저 온 쓰는 스레드들 뒤에 줄을 섬 */
+	lock_acquire (&rw->gate);
+	old_level = spin_lock_irqsave (&rw->lock);
+	rwlock_add_reader (rw);
+	spin_unlock_irqrestore (&rw->lock, old_level);
+	lock_release (&rw->gate);
+}
+
+/* 읽기 위해 얻었던 RW를 놓음 */
+void
+rwlock_release_read (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	struct rwlock_hold *h;
+	struct thread *writer;
+	struct thread *heir = NULL;
+	struct thread *woken = NULL;
+	enum intr_level old_level;
+	bool preempt;
+
+	ASSERT (rw != NULL);
+
+	old_level = spin_lock_irqsave (&rw->lock);
+	ASSERT (0 < rw->readers);
+	rw->readers--;
+	h = rwlock_hold_find (cur, rw);
+	if ((NULL != h) && (0 == --h->depth))
+	{
+		list_remove (&h->elem);
+		h->rw = NULL;
+
+		/* 쓰는 스레드의 기부를 회수하고 아직 읽고 있는 다음 스레드에게 넘김 */
+		writer = rw->drain_waiter;
+		if ((NULL != writer) && (cur == writer->donee))
+		{
+			spin_lock (&sched_lock);
+			heap_remove (&cur->donors, &writer->donor_elem);
+			writer->donee = NULL;
+			thread_refresh_priority (cur);
+			spin_unlock (&sched_lock);
+			heir = rwlock_donate (rw, writer);
+		}
+	}
+
+	/* 마지막으로 빠지는 읽는 스레드가 기다리던 쓰는 스레드를 깨움 */
+	if ((0 == rw->readers) && (NULL != rw->drain_waiter))
+	{
+		woken = rw->drain_waiter;
+		rw->drain_waiter = NULL;
+		thread_unblock (woken);
+	}
+	preempt = ((NULL != woken) && thread_should_preempt (woken))
+		|| ((NULL != heir) && thread_should_preempt (heir));
+	spin_unlock_irqrestore (&rw->lock, old_level);
+
+	if (preempt)
+	{
+		thread_preempt ();
+	}
+}
+
+/* RW를 쓰기 위해 얻음. 다른 쓰는 스레드가 끝나고, 이미 읽고 있던 */
+/* 스레드가 모두 빠질 때까지 잠듦. */
+/* 잠들 수 있으므로 인터럽트 핸들러 안에서 호출하면 안 됨 */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	/* 이제부터 새로 오는 읽는 스레드는 GATE에서 기다림 */
+	old_level = spin_lock_irqsave (&rw->lock);
+	rw->writers++;
+	spin_unlock_irqrestore (&rw->lock, old_level);
+
+	lock_acquire (&rw->gate);
+
+	old_level = spin_lock_irqsave (&rw->lock);
+	while (0 < rw->readers)
+	{
+		/* GATE를 잡고 있으므로 빠지기를 기다리는 스레드는 하나뿐 */
+		ASSERT (NULL == rw->drain_waiter);
+		rw->drain_waiter = cur;
+		if (NULL == cur->donee)
+		{
+			rwlock_donate (rw, cur);
+		}
+		thread_block_unlock (&rw->lock);
+		spin_lock (&rw->lock);
+	}
+	spin_unlock_irqrestore (&rw->lock, old_level);
+}
+
+/* 쓰기 위해 얻었던 RW를 놓음 */
+void
+rwlock_release_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_held_by_current_thread (rw));
+
+	old_level = spin_lock_irqsave (&rw->lock);
+	rw->writers--;
+	spin_unlock_irqrestore (&rw->lock, old_level);
+
+	lock_release (&rw->gate);
+}
+
+/* 현재 스레드가 RW를 쓰기 위해 잡고 있다면 true. */
+/* 읽는 스레드는 모두 기록되지는 않으므로 확인할 수 없음 */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->gate);
+}
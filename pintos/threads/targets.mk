@@ -3,7 +3,14 @@ threads_SRC += threads/thread.c		# Thread management core.
 threads_SRC += threads/interrupt.c	# Interrupt core.
 threads_SRC += threads/intr-stubs.S	# Interrupt stubs.
 threads_SRC += threads/synch.c		# Synchronization.
+threads_SRC += threads/spinlock.c	# Spinlocks for multiprocessor mutual exclusion.
+threads_SRC += threads/lockstat.c	# Lock contention profiling.
+threads_SRC += threads/sched-trace.c	# Scheduler latency tracing.
+threads_SRC += threads/cpu.c		# Per-CPU state and AP bring-up.
+threads_SRC += threads/ap-start.S	# AP startup trampoline.
 threads_SRC += threads/palloc.c		# Page allocator.
 threads_SRC += threads/malloc.c		# Subpage allocator.
+threads_SRC += threads/slab.c		# Slab allocator for fixed-size objects.
+threads_SRC += threads/fpu.c		# Lazy FPU/SSE context switching.
 threads_SRC += threads/start.S		# Startup code.
 threads_SRC += threads/mmu.c		    # Memory management unit related things.
@@ -1,13 +1,19 @@
 #include "threads/thread.h"
 #include <debug.h>
+#include <round.h>
 #include <stddef.h>
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/fixed-point.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/fpu.h"
 #include "threads/palloc.h"
+#include "threads/sched-trace.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
@@ -24,44 +30,110 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
+/* 우선순위 개수. 준비 큐 비트맵이 64비트이므로 64개를 넘을 수 없음. */
+#define PRI_CNT (PRI_MAX - PRI_MIN + 1)
+
+/* 우선순위별로 THREAD_READY 상태의 스레드를 담는 준비 큐. */
+/* 우선순위마다 리스트를 하나씩 두고, 비어있지 않은 리스트를 비트맵에 표시함. */
+/* 삽입은 리스트 끝에 붙이기만 하면 되고, 다음 스레드 선택은 비트맵에서 */
+/* 가장 높은 비트를 찾는 것으로 끝나기 때문에 모두 O(1). */
+struct run_queue {
+	struct list queues[PRI_CNT];        /* 우선순위별 준비 리스트. */
+	uint64_t bitmap;                    /* i번 비트 = queues[i]가 비어있지 않음. */
+	size_t cnt;                         /* 큐에 들어있는 스레드 수. */
+};
+
 /* List of processes in THREAD_READY state, that is, processes
    that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* Idle thread. */
-static struct thread *idle_thread;
+/* CPU마다 스케줄링 클래스별로 하나씩 있으며, cpus[i]에서 클래스 CLS의 */
+/* 준비 큐가 ready_queues[i][CLS]. */
+static struct run_queue ready_queues[CPU_MAX][SCHED_CLASS_CNT];
+
+/* 클래스별 단계. 단계가 높은 클래스의 스레드가 우선순위와 상관없이 먼저 실행됨. */
+/* 실시간 클래스 둘은 같은 단계라서 우선순위로 비교함 */
+#define BAND_RT 2
+static const int class_band[SCHED_CLASS_CNT] = {
+	[SCHED_FIFO] = BAND_RT,
+	[SCHED_RR] = BAND_RT,
+	[SCHED_NORMAL] = 1,
+	[SCHED_IDLE] = 0,
+};
+
+/* 모든 준비 큐, 스레드 상태 전이, 우선순위 기부 정보를 보호.
+   스레드를 전환하는 동안에도 잡혀 있다가, 전환되어 들어온 스레드가
+   schedule_tail() 뒤에 놓음. 그래서 전환되어 나간 스레드의 스택을
+   다른 CPU가 그 스레드를 실행하면서 덮어쓸 일이 없음.
+   락 순서: 세마포어의 락 -> sched_lock -> palloc, malloc의 락 */
+struct spinlock sched_lock;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
-static struct lock tid_lock;
-
-/* Thread destruction requests */
-static struct list destruction_req;
-
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
-
 /* Scheduling. */
-#define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
+#define TIME_SLICE_MS 40        /* 기본 타임 슬라이스 (밀리초). */
+
+/* 각 스레드에게 주는 타임 슬라이스 (밀리초). */
+/* 커널 명령줄 옵션 "-time-slice=MS"로 바꿀 수 있음 */
+int thread_time_slice_ms = TIME_SLICE_MS;
+static unsigned time_slice;     /* # of timer ticks to give each thread. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* MLFQS 스케줄러. */
+#define MLFQS_PRI_INTERVAL 4    /* 실행 중인 스레드의 우선순위를 다시 계산하는 tick 간격. */
+#define DECAY_RING 64           /* 기억해두는 초별 감쇠 계수 개수. */
+
+static fixed_t load_avg;        /* 최근 1분간 준비된 스레드 수의 평균. */
+static int64_t mlfqs_epoch;     /* 부팅 후 지난 초 수. */
+
+/* 초별 recent_cpu 감쇠 계수 (2*load_avg)/(2*load_avg + 1). */
+/* 잠들어 있던 스레드는 깨어날 때 그동안의 계수를 한꺼번에 적용함. */
+/* 덕분에 매 초마다 모든 스레드를 순회하지 않고 실행 중이거나 준비된 스레드만 갱신함 */
+static fixed_t decay_ring[DECAY_RING];
+
+static long long mlfqs_recomputes;  /* # of MLFQS priority recomputations. */
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
-static struct thread *next_thread_to_run (void);
+static void idle_loop (void) NO_RETURN;
+static struct thread *next_thread_to_run (struct cpu *);
 static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
+static void schedule_tail (void);
+static struct cpu *select_cpu (struct thread *);
+static int cpu_load (struct cpu *);
+static int cpu_mlfqs_load (struct cpu *);
+static size_t cpu_ready_cnt (struct cpu *);
+static enum sched_class cpu_top_class (struct cpu *);
+static int cpu_ready_rank (struct cpu *);
+static int cpu_curr_rank (struct cpu *);
+static int cpu_top_rank (struct cpu *);
+static int sched_rank (enum sched_class, int priority);
+static bool steal_threads (struct cpu *);
 static tid_t allocate_tid (void);
+static struct thread *thread_page_alloc (void);
+static void thread_page_free (struct cpu *, struct thread *);
+
+static void runq_init (struct run_queue *);
+static void runq_push (struct run_queue *, struct thread *);
+static void runq_push_front (struct run_queue *, struct thread *);
+static void runq_remove (struct run_queue *, struct thread *);
+static struct thread *runq_pop (struct run_queue *);
+static struct thread *runq_steal (struct run_queue *);
+static int runq_max_priority (const struct run_queue *);
+
+static void mlfqs_tick (struct cpu *, struct thread *);
+static void account_cpu_time (struct cpu *, struct thread *);
+static void mlfqs_second (void);
+static void mlfqs_catch_up (struct thread *);
+static void mlfqs_update_priority (struct thread *);
+
+static heap_less_func donor_less;
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -73,6 +145,12 @@ static tid_t allocate_tid (void);
  * somewhere in the middle, this locates the curent thread. */
 #define running_thread() ((struct thread *) (pg_round_down (rrsp ())))
 
+/* CPU C에서 클래스 CLS의 준비 큐. */
+#define cpu_runq(c, cls) (&ready_queues[(c)->id][cls])
+
+/* 스레드 T가 들어가는 준비 큐. */
+#define thread_runq(t) cpu_runq ((t)->cpu, (t)->policy)
+
 
 // Global descriptor table for the thread_start.
 // Because the gdt will be setup after the thread_init, we should
@@ -84,7 +162,7 @@ static uint64_t gdt[3] = { 0, 0x00af9a000000ffff, 0x00cf92000000ffff };
    general and it is possible in this case only because loader.S
    was careful to put the bottom of the stack at a page boundary.
 
-   Also initializes the run queue and the tid lock.
+   Also initializes the run queues and the scheduler lock.
 
    After calling this function, be sure to initialize the page
    allocator before trying to create any threads with
@@ -106,15 +184,68 @@ thread_init (void) {
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init (&tid_lock);
-	list_init (&ready_list);
-	list_init (&destruction_req);
+	spinlock_init (&sched_lock, "sched");
+	for (int i = 0; i < CPU_MAX; ++i)
+	{
+		for (int cls = 0; cls < SCHED_CLASS_CNT; ++cls)
+		{
+			runq_init (&ready_queues[i][cls]);
+		}
+	}
+	cpu_init ();
+
+	/* 타임 슬라이스를 tick 단위로 바꿈. 한 tick보다 짧을 수는 없음 */
+	if (thread_time_slice_ms < TIME_SLICE_MS_MIN
+			|| thread_time_slice_ms > TIME_SLICE_MS_MAX)
+		PANIC ("time slice %d ms out of range (%d...%d)",
+				thread_time_slice_ms, TIME_SLICE_MS_MIN, TIME_SLICE_MS_MAX);
+	time_slice = DIV_ROUND_UP ((int64_t) thread_time_slice_ms * TIMER_FREQ, 1000);
+	if (0 == time_slice)
+	{
+		time_slice = 1;
+	}
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
+	initial_thread->cpu = &cpus[0];
+	initial_thread->run_cpu = &cpus[0];
+	cpus[0].curr = initial_thread;
 	initial_thread->tid = allocate_tid ();
+	sched_trace_attach (initial_thread);
+}
+
+/* AP C에서 실행 중인 코드를 그 CPU의 idle 스레드로 만듦. */
+/* smp_init()이 준비한 스택 페이지 위에서 인터럽트가 꺼진 채로 호출됨 */
+void
+thread_init_ap (struct cpu *c) {
+	struct thread *t = running_thread ();
+	char name[16];
+	struct desc_ptr gdt_ds = {
+		.size = sizeof (gdt) - 1,
+		.address = (uint64_t) gdt
+	};
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lgdt (&gdt_ds);
+
+	snprintf (name, sizeof name, "idle%d", c->id);
+	init_thread (t, name, PRI_MIN);
+	t->status = THREAD_RUNNING;
+	t->cpu = c;
+	t->run_cpu = c;
+	t->tid = allocate_tid ();
+	c->curr = t;
+	c->idle_thread = t;
+	c->acct_ns = timer_ns ();
+}
+
+/* AP의 idle 스레드로서 스케줄링을 시작. 돌아오지 않음 */
+void
+thread_idle_ap (void) {
+	idle_loop ();
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -135,30 +266,100 @@ thread_start (void) {
 
 /* Called by the timer interrupt handler at each timer tick.
    Thus, this function runs in an external interrupt context. */
+/* BSP는 PIT, AP는 Local APIC 타이머에서 각자 호출함. */
 void
 thread_tick (void) {
+	struct cpu *c = this_cpu ();
 	struct thread *t = thread_current ();
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	account_cpu_time (c, t);
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
+		c->kernel_ticks++;
+
+	if (thread_mlfqs)
+	{
+		mlfqs_tick (c, t);
+	}
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	/* SCHED_FIFO 스레드는 스스로 양보하거나 잠들 때까지 빼앗지 않음 */
+	if ((++c->thread_ticks >= time_slice) && (SCHED_FIFO != t->policy))
 		intr_yield_on_return ();
 }
 
+/* CPU C에서 실행 중인 스레드 T가 마지막 정산 이후 쓴 CPU 시간을 */
+/* timer_ns()로 재서 통계에 더함. tick 경계와 스레드 전환마다 */
+/* 호출하므로, tick 도중에 잠들거나 양보한 스레드도 쓴 만큼 정확히 셈. */
+/* C에서 인터럽트를 끈 채로 호출 */
+static void
+account_cpu_time (struct cpu *c, struct thread *t) {
+	int64_t now = timer_ns ();
+	int64_t ran_ns = now - c->acct_ns;
+
+	c->acct_ns = now;
+	if (t == c->idle_thread)
+		c->idle_ns += ran_ns;
+#ifdef USERPROG
+	else if (t->pml4 != NULL)
+		c->user_ns += ran_ns;
+#endif
+	else
+		c->kernel_ns += ran_ns;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+	int64_t idle_ns = 0, kernel_ns = 0, user_ns = 0;
+	long long switches = 0, steals = 0, migrations = 0, reused = 0;
+
+	for (int i = 0; i < cpu_cnt; ++i)
+	{
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+		idle_ns += cpus[i].idle_ns;
+		kernel_ns += cpus[i].kernel_ns;
+		user_ns += cpus[i].user_ns;
+		switches += cpus[i].switch_cnt;
+		steals += cpus[i].steal_cnt;
+		migrations += cpus[i].migrate_cnt;
+		reused += cpus[i].thread_cache_hits;
+	}
+
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+	printf ("Thread: %lld us idle, %lld us kernel, %lld us user\n",
+			idle_ns / 1000, kernel_ns / 1000, user_ns / 1000);
+	printf ("Thread: %lld pages reused\n", reused);
+	if (1 < cpu_cnt)
+	{
+		/* 이동률은 스레드 전환 천 번당 다른 CPU로 옮겨간 횟수 */
+		printf ("Balance: %lld steals, %lld migrations in %lld switches "
+				"(%lld per 1000)\n", steals, migrations, switches,
+				0 < switches ? migrations * 1000 / switches : 0);
+		for (int i = 0; i < cpu_cnt; ++i)
+		{
+			printf ("CPU %d: %lld idle ticks, %lld kernel ticks, "
+					"%lld user ticks, %lld IPIs, %lld steals\n", i,
+					cpus[i].idle_ticks, cpus[i].kernel_ticks, cpus[i].user_ticks,
+					cpus[i].ipi_cnt, cpus[i].steal_cnt);
+		}
+	}
+	if (thread_mlfqs)
+	{
+		printf ("MLFQS: load_avg %d.%02d, %lld priority recomputes\n",
+				thread_get_load_avg () / 100, thread_get_load_avg () % 100,
+				mlfqs_recomputes);
+	}
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -186,8 +387,7 @@ thread_create (const char *name, int priority,
 
 	/* Allocate thread. */
 	/* 스레드 구조체를 할당받으면서 커널 스택까지 통채로 메모리 할당받음. */
-	/* PAL_ZERO 플래그를 통해 할당 후 0 초기화 */
-	t = palloc_get_page (PAL_ZERO);
+	t = thread_page_alloc ();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -197,6 +397,21 @@ thread_create (const char *name, int priority,
 	init_thread (t, name, priority);
 	/* 고유 ID(tid)를 할당. */
 	tid = t->tid = allocate_tid ();
+	sched_trace_attach (t);
+
+	/* 스케줄링 클래스는 만든 스레드의 원래 클래스를 물려받음 */
+	t->policy = t->base_policy = thread_current ()->base_policy;
+
+	/* MLFQS에서는 부모의 nice와 recent_cpu를 물려받고 우선순위는 직접 계산 */
+	if (thread_mlfqs)
+	{
+		struct thread *cur = thread_current ();
+
+		t->nice = cur->nice;
+		t->recent_cpu = cur->recent_cpu;
+		t->recent_cpu_epoch = cur->recent_cpu_epoch;
+		mlfqs_update_priority (t);
+	}
 
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
@@ -214,8 +429,9 @@ thread_create (const char *name, int priority,
 	t->tf.es = SEL_KDSEG;
 	t->tf.ss = SEL_KDSEG;
 	t->tf.cs = SEL_KCSEG;
-	/* 인터럽트 활성화하도록 플래그 레지스터 설정 */
-	t->tf.eflags = FLAG_IF;
+	/* 처음 실행될 때는 schedule()이 잡은 sched_lock을 이어받으므로 */
+	/* 인터럽트를 끈 채로 시작하고, kernel_thread()가 락을 놓은 뒤에 켬 */
+	t->tf.eflags = FLAG_MBS;
 
 #ifdef USERPROG
 	t->parent = thread_current();
@@ -225,6 +441,12 @@ thread_create (const char *name, int priority,
 	/* Add to run queue. */
 	thread_unblock (t);
 
+	/* 새 스레드가 이 CPU에 배정되었고 우선순위가 더 높다면 바로 CPU를 양보 */
+	if (thread_should_preempt (t))
+	{
+		thread_yield ();
+	}
+
 	return tid;
 }
 
@@ -238,8 +460,26 @@ void
 thread_block (void) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&sched_lock);
 	thread_current ()->status = THREAD_BLOCKED;
 	schedule ();
+	spin_unlock (&sched_lock);
+}
+
+/* thread_block()과 같지만, 현재 스레드를 재우는 것과 LOCK을 놓는 것을 */
+/* 원자적으로 함. LOCK을 놓는 순간부터 다른 CPU가 thread_unblock()을 */
+/* 부를 수 있는데, 그 전에 이미 sched_lock을 잡고 있으므로 깨우기를 놓치지 않음 */
+void
+thread_block_unlock (struct spinlock *lock) {
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spin_lock (&sched_lock);
+	spin_unlock (lock);
+	thread_current ()->status = THREAD_BLOCKED;
+	schedule ();
+	spin_unlock (&sched_lock);
 }
 
 /* Transitions a blocked thread T to the ready-to-run state.
@@ -253,14 +493,244 @@ thread_block (void) {
 void
 thread_unblock (struct thread *t) {
 	enum intr_level old_level;
+	struct cpu *c;
 
 	ASSERT (is_thread (t));
 
-	old_level = intr_disable ();
+	old_level = spin_lock_irqsave (&sched_lock);
 	ASSERT (t->status == THREAD_BLOCKED);
-	list_push_back (&ready_list, &t->elem);
+	if (thread_mlfqs)
+	{
+		/* 잠들어 있는 동안 밀린 감쇠를 반영하고 우선순위를 다시 계산 */
+		mlfqs_catch_up (t);
+		mlfqs_update_priority (t);
+	}
+	c = select_cpu (t);
+	if ((NULL != t->cpu) && (c != t->cpu))
+	{
+		c->migrate_cnt++;
+	}
+	t->cpu = c;
+	runq_push (thread_runq (t), t);
 	t->status = THREAD_READY;
-	intr_set_level (old_level);
+	sched_trace_ready (t);
+
+	/* 다른 CPU에 넣었다면, 그 CPU가 놀고 있거나 T가 더 급할 때만 깨움 */
+	if ((c != this_cpu ()) && (thread_rank (t) > cpu_curr_rank (c)))
+	{
+		cpu_kick (c);
+	}
+	spin_unlock_irqrestore (&sched_lock, old_level);
+}
+
+/* 깨어난 스레드 T를 넣을 CPU를 고름. sched_lock을 잡고 있어야 함. */
+/* 캐시 친화성 힌트: T의 데이터가 캐시에 남아있을 가능성이 높은 마지막 CPU를 */
+/* 우선하고, 그 CPU가 바쁠 때는 놀고 있는 CPU가 있을 때만 옮김. 남는 불균형은 */
+/* 일이 떨어진 CPU가 steal_threads()로 맞춤. 처음 실행되는 스레드는 캐시에 */
+/* 남은 것이 없으므로 가장 한가한 CPU로 보내서, fork가 많은 부하에서도 */
+/* 자식들이 부모의 CPU에 쌓이지 않도록 함. */
+/* 실시간 스레드는 부하보다 지연이 중요하므로, 마지막 CPU에 순위가 같거나 */
+/* 높은 스레드가 있다면 가장 낮은 순위를 실행 중인 CPU로 보내 곧바로 선점함 */
+static struct cpu *
+select_cpu (struct thread *t) {
+	struct cpu *best = (NULL != t->cpu) ? t->cpu : this_cpu ();
+	int best_load = cpu_load (best);
+
+	/* 고정된 스레드는 다른 곳으로 보내지 않음 */
+	if (NULL != t->bound_cpu)
+	{
+		return t->bound_cpu;
+	}
+
+	if ((BAND_RT == class_band[t->policy]) && (thread_rank (t) <= cpu_top_rank (best)))
+	{
+		struct cpu *low = best;
+		int low_rank = cpu_top_rank (best);
+
+		for (int i = 0; i < cpu_cnt; ++i)
+		{
+			int top = cpu_top_rank (&cpus[i]);
+
+			if (top < low_rank)
+			{
+				low = &cpus[i];
+				low_rank = top;
+			}
+		}
+
+		if (thread_rank (t) > low_rank)
+		{
+			return low;
+		}
+	}
+
+	for (int i = 0; (0 < best_load) && (i < cpu_cnt); ++i)
+	{
+		int load = cpu_load (&cpus[i]);
+
+		if ((load < best_load) && ((NULL == t->cpu) || (0 == load)))
+		{
+			best = &cpus[i];
+			best_load = load;
+		}
+	}
+
+	return best;
+}
+
+/* 준비 큐가 빈 CPU C가, 준비된 스레드가 가장 많은 CPU에서 클래스마다 절반을 */
+/* 훔쳐와 같은 클래스의 큐에 넣음. 도둑은 주인이 꺼내는 반대쪽, 즉 가장 낮은 */
+/* 우선순위 리스트의 끝에서부터 가져가므로 주인이 곧 실행할 스레드는 */
+/* 마지막까지 건드리지 않음. */
+/* thread_bind_cpu()로 고정된 스레드는 훔치지 않음. */
+/* 훔쳐온 스레드가 있다면 true. sched_lock을 잡고 있어야 함 */
+static bool
+steal_threads (struct cpu *c) {
+	struct cpu *victim = NULL;
+	size_t most = 0;
+	bool stolen = false;
+
+	ASSERT (spin_held (&sched_lock));
+
+	for (int i = 0; i < cpu_cnt; ++i)
+	{
+		struct cpu *peer = &cpus[i];
+
+		if ((peer != c) && (most < cpu_ready_cnt (peer)))
+		{
+			victim = peer;
+			most = cpu_ready_cnt (peer);
+		}
+	}
+
+	if (NULL == victim)
+	{
+		return false;
+	}
+
+	for (int cls = 0; cls < SCHED_CLASS_CNT; ++cls)
+	{
+		for (size_t n = (cpu_runq (victim, cls)->cnt + 1) / 2; 0 < n; --n)
+		{
+			struct thread *t = runq_steal (cpu_runq (victim, cls));
+
+			if (NULL == t)
+			{
+				break;
+			}
+
+			t->cpu = c;
+			runq_push (thread_runq (t), t);
+			c->steal_cnt++;
+			c->migrate_cnt++;
+			stolen = true;
+		}
+	}
+
+	return stolen;
+}
+
+/* CPU C에서 실행 중이거나 실행을 기다리는 스레드 수 (idle 제외). */
+/* sched_lock을 잡고 있어야 함 */
+static int
+cpu_load (struct cpu *c) {
+	return cpu_ready_cnt (c) + (c->curr != c->idle_thread ? 1 : 0);
+}
+
+/* CPU C에서 실행 중이거나 실행을 기다리는 시분할 클래스(SCHED_NORMAL, */
+/* SCHED_IDLE) 스레드 수. 실시간 클래스는 MLFQS가 우선순위를 매기지 */
+/* 않으므로 load_avg에도 세지 않음. 타이머 인터럽트가 깨운 하반부 작업 */
+/* 스레드(SCHED_FIFO)도 그래서 빠짐. sched_lock을 잡고 있어야 함 */
+static int
+cpu_mlfqs_load (struct cpu *c) {
+	int cnt = cpu_runq (c, SCHED_NORMAL)->cnt + cpu_runq (c, SCHED_IDLE)->cnt;
+
+	if ((c->curr != c->idle_thread) && ((SCHED_NORMAL == c->curr->policy)
+				|| (SCHED_IDLE == c->curr->policy)))
+	{
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/* CPU C의 모든 클래스 준비 큐에 들어있는 스레드 수. sched_lock을 잡고 있어야 함 */
+static size_t
+cpu_ready_cnt (struct cpu *c) {
+	size_t cnt = 0;
+
+	for (int cls = 0; cls < SCHED_CLASS_CNT; ++cls)
+	{
+		cnt += cpu_runq (c, cls)->cnt;
+	}
+
+	return cnt;
+}
+
+/* CPU C의 준비된 스레드 중 순위가 가장 높은 스레드의 클래스. */
+/* 실시간 클래스끼리 순위가 같다면 앞에 있는 SCHED_FIFO를 고름. */
+/* 준비된 스레드가 없다면 SCHED_CLASS_CNT. sched_lock을 잡고 있어야 함 */
+static enum sched_class
+cpu_top_class (struct cpu *c) {
+	enum sched_class top = SCHED_CLASS_CNT;
+	int top_rank = -1;
+
+	for (int cls = 0; cls < SCHED_CLASS_CNT; ++cls)
+	{
+		struct run_queue *rq = cpu_runq (c, cls);
+
+		if ((0 < rq->cnt) && (sched_rank (cls, runq_max_priority (rq)) > top_rank))
+		{
+			top = cls;
+			top_rank = sched_rank (cls, runq_max_priority (rq));
+		}
+	}
+
+	return top;
+}
+
+/* CPU C의 준비된 스레드 중 가장 높은 순위. 없다면 -1. */
+/* sched_lock을 잡고 있어야 함 */
+static int
+cpu_ready_rank (struct cpu *c) {
+	enum sched_class cls = cpu_top_class (c);
+
+	if (SCHED_CLASS_CNT == cls)
+	{
+		return -1;
+	}
+
+	return sched_rank (cls, runq_max_priority (cpu_runq (c, cls)));
+}
+
+/* CPU C에서 실행 중인 스레드의 순위. idle 스레드라면 어떤 스레드보다도 */
+/* 낮은 -1. sched_lock을 잡고 있거나 C에서 인터럽트를 끈 채로 호출 */
+static int
+cpu_curr_rank (struct cpu *c) {
+	return (c->curr == c->idle_thread) ? -1 : thread_rank (c->curr);
+}
+
+/* CPU C에서 실행 중이거나 준비된 스레드 중 가장 높은 순위. */
+/* sched_lock을 잡고 있어야 함 */
+static int
+cpu_top_rank (struct cpu *c) {
+	int curr = cpu_curr_rank (c);
+	int ready = cpu_ready_rank (c);
+
+	return curr > ready ? curr : ready;
+}
+
+/* 클래스 CLS에서 우선순위가 PRIORITY인 스레드의 순위. 값이 클수록 먼저 실행됨. */
+/* 클래스 단계가 우선순위보다 먼저 비교되도록 단계에 우선순위 개수를 곱함 */
+static int
+sched_rank (enum sched_class cls, int priority) {
+	return class_band[cls] * PRI_CNT + priority;
+}
+
+/* 스레드 T의 스케줄링 순위. 기부받은 클래스와 우선순위를 반영함 */
+int
+thread_rank (const struct thread *t) {
+	return sched_rank (t->policy, t->priority);
 }
 
 /* Returns the name of the running thread. */
@@ -306,6 +776,7 @@ thread_exit (void) {
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	spin_lock (&sched_lock);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -319,17 +790,236 @@ thread_yield (void) {
 
 	ASSERT (!intr_context ());
 
-	old_level = intr_disable ();
-	if (curr != idle_thread)
-		list_push_back (&ready_list, &curr->elem);
+	old_level = spin_lock_irqsave (&sched_lock);
+	if (curr != curr->cpu->idle_thread)
+	{
+		if (thread_mlfqs)
+		{
+			mlfqs_update_priority (curr);
+		}
+		runq_push (thread_runq (curr), curr);
+		sched_trace_ready (curr);
+	}
 	do_schedule (THREAD_READY);
-	intr_set_level (old_level);
+	spin_unlock_irqrestore (&sched_lock, old_level);
+}
+
+/* 외부 인터럽트가 끝날 때 intr_yield_on_return()을 요청받았다면 */
+/* intr_handler()가 호출. 타임 슬라이스를 다 썼다면 thread_yield()와 같고, */
+/* 다 쓰기 전에 더 급한 스레드에게 선점되었다면 자기 우선순위 리스트의 */
+/* 맨 앞으로 돌아가 다음에 쓰던 슬라이스를 이어서 씀. */
+/* 깨어난 하반부 작업 스레드(intrd)에게 잠깐 선점될 때마다 줄 맨 뒤로 */
+/* 밀리면 RR과 MLFQS의 순서가 바뀌기 때문 */
+void
+thread_yield_preempted (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	old_level = spin_lock_irqsave (&sched_lock);
+	if (curr != curr->cpu->idle_thread)
+	{
+		struct cpu *c = curr->cpu;
+
+		if (thread_mlfqs)
+		{
+			mlfqs_update_priority (curr);
+		}
+
+		/* SCHED_FIFO 스레드는 슬라이스가 없으므로 항상 선점된 것 */
+		if ((c->thread_ticks < time_slice) || (SCHED_FIFO == curr->policy))
+		{
+			curr->slice_ticks = c->thread_ticks;
+			runq_push_front (thread_runq (curr), curr);
+		}
+		else
+		{
+			runq_push (thread_runq (curr), curr);
+		}
+		sched_trace_ready (curr);
+	}
+	do_schedule (THREAD_READY);
+	spin_unlock_irqrestore (&sched_lock, old_level);
+}
+
+/* 현재 스레드를 CPU C에 고정. 다른 CPU에서 돌고 있었다면 C로 옮겨간 뒤 */
+/* 반환함. 고정된 스레드는 select_cpu()와 steal_threads()가 다른 CPU로 */
+/* 옮기지 않음. C가 NULL이면 고정을 풂 */
+void
+thread_bind_cpu (struct cpu *c) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+
+	old_level = spin_lock_irqsave (&sched_lock);
+	cur->bound_cpu = c;
+	if ((NULL != c) && (c != cur->cpu))
+	{
+		/* 아직 이 CPU의 스택 위에서 돌고 있으므로 C의 준비 큐에 바로 넣을 */
+		/* 수 없음. 목적지만 기록해 두고 이 CPU에서 전환해 나가면, */
+		/* schedule_tail()이 C의 준비 큐로 옮겨줌 */
+		cur->cpu = c;
+		do_schedule (THREAD_READY);
+	}
+	spin_unlock_irqrestore (&sched_lock, old_level);
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
-	thread_current ()->priority = new_priority;
+	/* MLFQS에서는 우선순위를 스케줄러가 직접 관리하므로 무시 */
+	if (thread_mlfqs)
+	{
+		return;
+	}
+
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool yield;
+
+	/* 기부받은 우선순위는 유지하고 원래 우선순위만 바꾼 뒤 다시 계산 */
+	old_level = spin_lock_irqsave (&sched_lock);
+	cur->base_priority = new_priority;
+	thread_refresh_priority (cur);
+	yield = cpu_ready_rank (cur->cpu) > thread_rank (cur);
+	spin_unlock_irqrestore (&sched_lock, old_level);
+
+	/* 우선순위를 낮춘 결과 더 높은 우선순위의 준비된 스레드가 생겼다면 양보 */
+	if (yield)
+	{
+		thread_yield ();
+	}
+}
+
+/* 현재 스레드를 스케줄링 클래스 CLS로 옮기고 클래스 안의 우선순위를 */
+/* PRIORITY로 바꿈. MLFQS에서 SCHED_NORMAL로 옮긴다면 PRIORITY는 무시하고 */
+/* 스케줄러가 계산함. 인자가 올바르지 않다면 아무것도 바꾸지 않고 false */
+bool
+thread_set_class (enum sched_class cls, int priority) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool yield;
+
+	if ((SCHED_CLASS_CNT <= (unsigned) cls)
+			|| (PRI_MIN > priority) || (PRI_MAX < priority))
+	{
+		return false;
+	}
+
+	old_level = spin_lock_irqsave (&sched_lock);
+	cur->base_policy = cls;
+	cur->base_priority = priority;
+	if (thread_mlfqs)
+	{
+		/* MLFQS에는 기부가 없으므로 원래 값이 곧 실제 값 */
+		cur->policy = cls;
+		cur->priority = priority;
+		mlfqs_update_priority (cur);
+	}
+	else
+	{
+		thread_refresh_priority (cur);
+	}
+	yield = cpu_ready_rank (cur->cpu) > thread_rank (cur);
+	spin_unlock_irqrestore (&sched_lock, old_level);
+
+	/* 클래스를 낮춘 결과 더 급한 스레드가 준비되어 있다면 양보 */
+	if (yield)
+	{
+		thread_yield ();
+	}
+
+	return true;
+}
+
+/* 현재 스레드의 스케줄링 클래스를 반환. */
+enum sched_class
+thread_get_class (void) {
+	return thread_current ()->policy;
+}
+
+/* 스레드 T의 실제 우선순위와 클래스를 원래 값과 기부받은 값 중 순위가 */
+/* 높은 쪽으로 다시 계산. 기부자들은 최대 힙에 있으므로 top만 보면 됨. */
+/* 실시간 스레드가 기다리는 락을 잡은 보통 스레드도 실시간 클래스로 올라가야 */
+/* 그 사이에 다른 보통 스레드에게 밀리지 않음. */
+/* T가 준비 큐나 다른 스레드의 기부자 힙에 있다면 새 순위에 맞게 옮김. */
+/* 순위가 바뀌었다면 true 반환. sched_lock을 잡고 있어야 함 */
+bool
+thread_refresh_priority (struct thread *t) {
+	int priority = t->base_priority;
+	enum sched_class policy = t->base_policy;
+
+	ASSERT (spin_held (&sched_lock));
+
+	/* MLFQS에서는 기부가 없고 우선순위는 mlfqs_update_priority()가 관리 */
+	if (thread_mlfqs)
+	{
+		return false;
+	}
+
+	if (!heap_empty (&t->donors))
+	{
+		struct thread *top = heap_entry (heap_top (&t->donors),
+				struct thread, donor_elem);
+
+		if (thread_rank (top) > sched_rank (policy, priority))
+		{
+			priority = top->priority;
+			policy = top->policy;
+		}
+	}
+
+	if ((priority == t->priority) && (policy == t->policy))
+	{
+		return false;
+	}
+
+	/* 우선순위를 키로 쓰는 자료구조에서 먼저 빼고, 바꾼 뒤 다시 넣음 */
+	if (NULL != t->donee)
+	{
+		heap_remove (&t->donee->donors, &t->donor_elem);
+	}
+
+	if (THREAD_READY == t->status)
+	{
+		runq_remove (thread_runq (t), t);
+		t->priority = priority;
+		t->policy = policy;
+		runq_push (thread_runq (t), t);
+	}
+	else
+	{
+		t->priority = priority;
+		t->policy = policy;
+	}
+
+	if (NULL != t->donee)
+	{
+		heap_push (&t->donee->donors, &t->donor_elem);
+	}
+
+	return true;
+}
+
+/* 방금 깨어난 스레드 T가 이 CPU의 준비 큐에 들어갔고 현재 스레드보다 */
+/* 순위가 높다면 true. 다른 CPU에 들어갔다면 그 CPU는 */
+/* thread_unblock()에서 이미 깨웠음 */
+bool
+thread_should_preempt (const struct thread *t) {
+	return (t->cpu == this_cpu ()) && (thread_rank (t) > cpu_curr_rank (t->cpu));
+}
+
+/* 현재 스레드가 CPU를 양보. 인터럽트 핸들러 안이라면 핸들러가 끝날 때 양보함 */
+void
+thread_preempt (void) {
+	if (intr_context ())
+	{
+		intr_yield_on_return ();
+	}
+	else
+	{
+		thread_yield ();
+	}
 }
 
 /* Returns the current thread's priority. */
@@ -340,29 +1030,53 @@ thread_get_priority (void) {
 
 /* Sets the current thread's nice value to NICE. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool yield;
+
+	/* nice는 NICE_MIN ~ NICE_MAX 범위로 제한 */
+	if (NICE_MIN > nice)
+	{
+		nice = NICE_MIN;
+	}
+	else if (NICE_MAX < nice)
+	{
+		nice = NICE_MAX;
+	}
+
+	old_level = spin_lock_irqsave (&sched_lock);
+	cur->nice = nice;
+	if (thread_mlfqs)
+	{
+		mlfqs_update_priority (cur);
+	}
+	yield = cpu_ready_rank (cur->cpu) > thread_rank (cur);
+	spin_unlock_irqrestore (&sched_lock, old_level);
+
+	/* 더 높은 우선순위의 스레드가 준비되어 있다면 양보 */
+	if (yield)
+	{
+		thread_yield ();
+	}
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return fp_round (fp_mul_int (load_avg, 100));
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return fp_round (fp_mul_int (thread_current ()->recent_cpu, 100));
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -374,14 +1088,27 @@ thread_get_recent_cpu (void) {
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
    special case when the ready list is empty. */
+/* BSP의 idle 스레드. AP는 thread_init_ap()에서 만든 idle 스레드가 */
+/* 곧바로 idle_loop()로 들어감 */
 static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current ();
+	this_cpu ()->idle_thread = thread_current ();
 	sema_up (idle_started);
 
+	idle_loop ();
+}
+
+/* idle 스레드의 본체. */
+static void
+idle_loop (void) {
 	for (;;) {
+		/* 할 일이 없는 동안 빈 페이지를 미리 0으로 채워둠. 인터럽트를 켠 */
+		/* 채로 한 페이지씩 채우므로 스레드가 깨어나면 바로 선점됨 */
+		while (palloc_prezero ())
+			continue;
+
 		/* Let someone else run. */
 		intr_disable ();
 		thread_block ();
@@ -407,12 +1134,182 @@ static void
 kernel_thread (thread_func *function, void *aux) {
 	ASSERT (function != NULL);
 
+	/* schedule()에서 이어받은 sched_lock을 놓음 */
+	schedule_tail ();
+	spin_unlock (&sched_lock);
 	intr_enable ();       /* The scheduler runs with interrupts off. */
 	function (aux);       /* Execute the thread function. */
 	thread_exit ();       /* If function() returns, kill the thread. */
 }
 
 
+/* MLFQS에서 매 tick마다 호출됨. CPU C의 타이머 인터럽트 안에서 실행 */
+/* 4.4BSD 스케줄러대로 tick이 울릴 때 실행 중인 스레드 T의 recent_cpu를 */
+/* 1 올리고, 매 초마다 load_avg와 recent_cpu를 갱신함. */
+/* 나노초 단위로 잰 CPU 시간은 통계에만 씀. */
+/* 우선순위는 recent_cpu가 바뀐 스레드만 다시 계산함 */
+static void
+mlfqs_tick (struct cpu *c, struct thread *t) {
+	/* 전역 tick은 BSP만 세므로 AP는 자기 타이머가 울린 횟수를 기준으로 함 */
+	int64_t now = (0 == c->id) ? timer_ticks ()
+		: c->idle_ticks + c->kernel_ticks + c->user_ticks;
+
+	spin_lock (&sched_lock);
+
+	/* 실행 중인 스레드가 recent_cpu가 바뀐 유일한 스레드 */
+	if (t != c->idle_thread)
+	{
+		t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+	}
+
+	if ((0 == c->id) && (0 == now % TIMER_FREQ))
+	{
+		mlfqs_second ();
+	}
+
+	/* 4 tick마다 실행 중인 스레드의 우선순위만 다시 계산. */
+	/* 준비 큐에 있는 스레드는 큐에 들어간 뒤로 recent_cpu가 바뀌지 않았음 */
+	if (0 == now % MLFQS_PRI_INTERVAL)
+	{
+		if (t != c->idle_thread)
+		{
+			mlfqs_update_priority (t);
+		}
+
+		if (cpu_ready_rank (c) > cpu_curr_rank (c))
+		{
+			intr_yield_on_return ();
+		}
+	}
+
+	spin_unlock (&sched_lock);
+}
+
+/* 1초마다 load_avg를 갱신하고, 실행 중이거나 준비된 스레드의 */
+/* recent_cpu를 감쇠시킨 뒤 우선순위를 다시 계산함. */
+/* 잠들어 있는 스레드는 깨어날 때 mlfqs_catch_up()으로 반영. */
+/* BSP에서 sched_lock을 잡고 호출하며 모든 CPU의 스레드를 갱신함 */
+static void
+mlfqs_second (void) {
+	int ready_threads = 0;
+	fixed_t twice_load;
+
+	ASSERT (spin_held (&sched_lock));
+
+	/* load_avg = (59/60)*load_avg + (1/60)*ready_threads */
+	for (int i = 0; i < cpu_cnt; ++i)
+	{
+		ready_threads += cpu_mlfqs_load (&cpus[i]);
+	}
+	load_avg = fp_add (fp_div_int (fp_mul_int (load_avg, 59), 60),
+			fp_div_int (fp_from_int (ready_threads), 60));
+
+	/* 이번 초의 감쇠 계수 기록 */
+	mlfqs_epoch++;
+	twice_load = fp_mul_int (load_avg, 2);
+	decay_ring[mlfqs_epoch % DECAY_RING] = fp_div (twice_load,
+			fp_add_int (twice_load, 1));
+
+	for (int i = 0; i < cpu_cnt; ++i)
+	{
+		struct cpu *c = &cpus[i];
+		struct run_queue *rq = cpu_runq (c, SCHED_NORMAL);
+		struct list ready;
+
+		if (c->curr != c->idle_thread)
+		{
+			mlfqs_catch_up (c->curr);
+			mlfqs_update_priority (c->curr);
+		}
+
+		/* 준비된 스레드는 우선순위가 바뀌면 다른 리스트로 옮겨야 하므로 */
+		/* 전부 꺼냈다가 새 우선순위로 다시 넣음. 우선순위를 직접 정하는 */
+		/* 다른 클래스의 스레드는 그대로 둠 */
+		list_init (&ready);
+		while (0 < rq->cnt)
+		{
+			struct thread *t = runq_pop (rq);
+
+			list_push_back (&ready, &t->elem);
+		}
+		while (!list_empty (&ready))
+		{
+			struct thread *t = list_entry (list_pop_front (&ready),
+					struct thread, elem);
+
+			mlfqs_catch_up (t);
+			mlfqs_update_priority (t);
+			runq_push (rq, t);
+		}
+	}
+}
+
+/* 스레드 T의 recent_cpu에 아직 반영되지 않은 초별 감쇠를 적용. */
+/* recent_cpu = (2*load_avg)/(2*load_avg + 1) * recent_cpu + nice */
+static void
+mlfqs_catch_up (struct thread *t) {
+	while (t->recent_cpu_epoch < mlfqs_epoch)
+	{
+		int64_t sec = ++t->recent_cpu_epoch;
+		fixed_t prev = t->recent_cpu;
+		fixed_t coef;
+
+		if (DECAY_RING > mlfqs_epoch - sec)
+		{
+			coef = decay_ring[sec % DECAY_RING];
+		}
+		else
+		{
+			/* 기억하지 못하는 오래전 계수는 남아있는 가장 오래된 계수로 대신함 */
+			coef = decay_ring[(mlfqs_epoch + 1) % DECAY_RING];
+		}
+
+		t->recent_cpu = fp_add_int (fp_mul (coef, t->recent_cpu), t->nice);
+
+		/* 오래 잠들어 있던 경우 값이 수렴했다면 기억하는 구간으로 건너뜀 */
+		if ((prev == t->recent_cpu) && (DECAY_RING <= mlfqs_epoch - sec))
+		{
+			t->recent_cpu_epoch = mlfqs_epoch - DECAY_RING + 1;
+		}
+	}
+}
+
+/* 스레드 T의 우선순위를 MLFQS 공식에 따라 다시 계산. */
+/* priority = PRI_MAX - (recent_cpu / 4) - (nice * 2) */
+/* SCHED_NORMAL이 아닌 스레드는 자신이 정한 우선순위를 유지함 */
+static void
+mlfqs_update_priority (struct thread *t) {
+	int priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4))
+		- t->nice * 2;
+
+	if (SCHED_NORMAL != t->policy)
+	{
+		return;
+	}
+
+	if (PRI_MIN > priority)
+	{
+		priority = PRI_MIN;
+	}
+	else if (PRI_MAX < priority)
+	{
+		priority = PRI_MAX;
+	}
+
+	t->priority = priority;
+	mlfqs_recomputes++;
+}
+
+/* 기부자 힙 정렬 함수. 순위가 더 높은 스레드가 top에 오도록 함 */
+static bool
+donor_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, donor_elem);
+	const struct thread *b = heap_entry (b_, struct thread, donor_elem);
+
+	return thread_rank (a) > thread_rank (b);
+}
+
 /* Does basic initialization of T as a blocked thread named
    NAME. */
 static void
@@ -426,8 +1323,16 @@ init_thread (struct thread *t, const char *name, int priority) {
 	strlcpy (t->name, name, sizeof t->name);
 	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *);
 	t->priority = priority;
+	t->policy = SCHED_NORMAL;
 	t->magic = THREAD_MAGIC;
 
+	/* 우선순위 기부 정보 초기화 */
+	t->base_priority = priority;
+	t->base_policy = SCHED_NORMAL;
+	t->wait_on_lock = NULL;
+	t->donee = NULL;
+	heap_init (&t->donors, donor_less, NULL);
+
 #ifdef USERPROG
 	/* 부모 프로세스를 우선 NULL로 초기화 */
 	t->parent = NULL;
@@ -440,19 +1345,14 @@ init_thread (struct thread *t, const char *name, int priority) {
 	/* wait() 호출 여부 플래그 초기화 */
 	t->is_waited = false;
 
-	/* 파일 디스크립터 테이블 초기화 */
-	for (int i = 0; i < FDT_COUNT_LIMIT; ++i)
-	{
-		t->fd_table[i] = NULL;
-	}
-
 	/* fork 동기화를 위한 세마포어 초기화 */
 	sema_init(&t->fork_sema, 0);
 	/* 부모 유저 스택 정보를 자식에게 전달하기 위한 포인터를 NULL로 초기화 */
 	t->parent_if = NULL;
 
-	/* 실행 파일 포인터 초기화 */
-	t->exec_file = NULL;
+	/* 프로세스는 initd, fork, clone이 정해줌 */
+	t->proc = NULL;
+	t->user_stack = NULL;
 #endif
 }
 
@@ -461,12 +1361,128 @@ init_thread (struct thread *t, const char *name, int priority) {
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
    idle_thread. */
+/* CPU C의 준비 큐 중 순위가 가장 높은 클래스의 큐에서 고르며, 모두 */
+/* 비어있다면 idle로 가기 전에 다른 CPU에서 훔쳐옴 */
 static struct thread *
-next_thread_to_run (void) {
-	if (list_empty (&ready_list))
-		return idle_thread;
+next_thread_to_run (struct cpu *c) {
+	if ((0 == cpu_ready_cnt (c)) && ((1 == cpu_cnt) || !steal_threads (c)))
+		return c->idle_thread;
 	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+		return runq_pop (cpu_runq (c, cpu_top_class (c)));
+}
+
+/* 준비 큐 RQ를 빈 상태로 초기화 */
+static void
+runq_init (struct run_queue *rq) {
+	ASSERT (PRI_CNT <= 64);
+
+	for (int i = 0; i < PRI_CNT; ++i)
+	{
+		list_init (&rq->queues[i]);
+	}
+
+	rq->bitmap = 0;
+	rq->cnt = 0;
+}
+
+/* 스레드 T를 자신의 우선순위 리스트 끝에 넣음. 같은 우선순위끼리는 라운드 로빈 */
+static void
+runq_push (struct run_queue *rq, struct thread *t) {
+	int idx = t->priority - PRI_MIN;
+
+	ASSERT (0 <= idx && idx < PRI_CNT);
+
+	list_push_back (&rq->queues[idx], &t->elem);
+	rq->bitmap |= 1ULL << idx;
+	rq->cnt++;
+}
+
+/* 스레드 T를 자신의 우선순위 리스트 맨 앞에 넣음. 선점된 스레드가 같은 */
+/* 우선순위의 다른 스레드보다 먼저 돌아오도록 할 때 사용 */
+static void
+runq_push_front (struct run_queue *rq, struct thread *t) {
+	int idx = t->priority - PRI_MIN;
+
+	ASSERT (0 <= idx && idx < PRI_CNT);
+
+	list_push_front (&rq->queues[idx], &t->elem);
+	rq->bitmap |= 1ULL << idx;
+	rq->cnt++;
+}
+
+/* 준비 큐 RQ에 들어있는 스레드 T를 꺼냄. */
+/* T의 priority는 RQ에 넣을 때와 같아야 함. */
+static void
+runq_remove (struct run_queue *rq, struct thread *t) {
+	int idx = t->priority - PRI_MIN;
+
+	ASSERT (0 < rq->cnt);
+
+	list_remove (&t->elem);
+	if (list_empty (&rq->queues[idx]))
+	{
+		rq->bitmap &= ~(1ULL << idx);
+	}
+	rq->cnt--;
+}
+
+/* 준비 큐 RQ에서 가장 높은 우선순위 리스트의 맨 앞 스레드를 꺼내 반환. */
+/* RQ는 비어있으면 안 됨. */
+static struct thread *
+runq_pop (struct run_queue *rq) {
+	int idx = runq_max_priority (rq) - PRI_MIN;
+	struct thread *t;
+
+	ASSERT (0 < rq->cnt);
+
+	t = list_entry (list_pop_front (&rq->queues[idx]), struct thread, elem);
+	if (list_empty (&rq->queues[idx]))
+	{
+		rq->bitmap &= ~(1ULL << idx);
+	}
+	rq->cnt--;
+
+	return t;
+}
+
+/* 준비 큐 RQ에서 다른 CPU로 옮길 수 있는 스레드를 가장 낮은 우선순위 */
+/* 리스트부터 맨 뒤에서 찾아 꺼내 반환. CPU에 고정된 스레드는 건너뜀. */
+/* 다른 CPU가 훔쳐갈 때 사용. 옮길 스레드가 없다면 NULL */
+static struct thread *
+runq_steal (struct run_queue *rq) {
+	for (uint64_t bits = rq->bitmap; 0 != bits; )
+	{
+		int idx = __builtin_ctzll (bits);
+		struct list *l = &rq->queues[idx];
+
+		for (struct list_elem *e = list_rbegin (l); e != list_rend (l);
+				e = list_prev (e))
+		{
+			struct thread *t = list_entry (e, struct thread, elem);
+
+			if (NULL == t->bound_cpu)
+			{
+				runq_remove (rq, t);
+				return t;
+			}
+		}
+		bits &= ~(1ULL << idx);
+	}
+
+	return NULL;
+}
+
+/* 준비 큐 RQ에 있는 스레드 중 가장 높은 우선순위를 반환. */
+/* 비어있다면 PRI_MIN - 1 반환. */
+/* 비트맵의 최상위 비트 위치가 곧 가장 높은 우선순위 (bsr 한 번) */
+static int
+runq_max_priority (const struct run_queue *rq) {
+	if (0 == rq->bitmap)
+	{
+		return PRI_MIN - 1;
+	}
+
+	return PRI_MIN + 63 - __builtin_clzll (rq->bitmap);
 }
 
 /* Use iretq to launch the thread */
@@ -570,32 +1586,44 @@ thread_launch (struct thread *th) {
  * This function modify current thread's status to status and then
  * finds another thread to run and switches to it.
  * It's not safe to call printf() in the schedule(). */
+/* sched_lock을 잡은 채로 호출 */
 static void
 do_schedule(int status) {
 	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held (&sched_lock));
 	ASSERT (thread_current()->status == THREAD_RUNNING);
-	while (!list_empty (&destruction_req)) {
-		struct thread *victim =
-			list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
-	}
 	thread_current ()->status = status;
 	schedule ();
 }
 
+/* sched_lock을 잡은 채로 들어와서, 다시 이 스레드로 전환되어 */
+/* 돌아올 때도 sched_lock을 잡은 채로 반환함 */
 static void
 schedule (void) {
+	struct cpu *c = this_cpu ();
 	struct thread *curr = running_thread ();
-	struct thread *next = next_thread_to_run ();
+	struct thread *next = next_thread_to_run (c);
 
 	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (spin_held (&sched_lock));
 	ASSERT (curr->status != THREAD_RUNNING);
 	ASSERT (is_thread (next));
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	next->cpu = c;
+	next->run_cpu = c;
+	c->curr = next;
 
-	/* Start new time slice. */
-	thread_ticks = 0;
+	/* Start new time slice. 선점되었던 스레드는 쓰던 슬라이스를 이어감 */
+	c->thread_ticks = next->slice_ticks;
+	next->slice_ticks = 0;
+	sched_trace_switch (curr, next);
+
+	/* 나가는 스레드가 지난 정산 이후 쓴 시간을 통계에 정산 */
+	if (curr != next)
+	{
+		account_cpu_time (c, curr);
+	}
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -603,33 +1631,94 @@ schedule (void) {
 #endif
 
 	if (curr != next) {
-		/* If the thread we switched from is dying, destroy its struct
-		   thread. This must happen late so that thread_exit() doesn't
-		   pull out the rug under itself.
-		   We just queuing the page free reqeust here because the page is
-		   currently used by the stack.
-		   The real destruction logic will be called at the beginning of the
-		   schedule(). */
-		if (curr && curr->status == THREAD_DYING && curr != initial_thread) {
-			ASSERT (curr != next);
-			list_push_back (&destruction_req, &curr->elem);
-		}
-
 		/* Before switching the thread, we first save the information
 		 * of current running. */
+		c->switch_cnt++;
+		c->prev = curr;
+		fpu_switch (curr);
 		thread_launch (next);
+		schedule_tail ();
+	}
+}
+
+/* 스레드 전환을 마무리. 전환되어 들어온 스레드가 sched_lock을 잡은 채로 */
+/* 호출함. 전환되어 나간 스레드가 종료 중이었다면 이제 아무도 그 스택을 */
+/* 쓰지 않으므로 해제함 */
+static void
+schedule_tail (void) {
+	struct cpu *c = this_cpu ();
+	struct thread *prev = c->prev;
+
+	ASSERT (spin_held (&sched_lock));
+
+	c->prev = NULL;
+	if ((NULL != prev) && (THREAD_READY == prev->status) && (c != prev->cpu))
+	{
+		/* thread_bind_cpu()로 다른 CPU에 고정되며 전환해 나간 스레드 */
+		struct cpu *target = prev->cpu;
+
+		target->migrate_cnt++;
+		runq_push (thread_runq (prev), prev);
+		sched_trace_ready (prev);
+		if (thread_rank (prev) > cpu_curr_rank (target))
+		{
+			cpu_kick (target);
+		}
+	}
+	else if ((NULL != prev) && (THREAD_DYING == prev->status)
+			&& (prev != initial_thread))
+	{
+		fpu_release (prev);
+		thread_page_free (c, prev);
+	}
+}
+
+/* 새 스레드의 페이지를 할당. 이 CPU에서 최근에 종료된 스레드의 페이지가 */
+/* 남아있다면 페이지 풀의 비트맵과 락을 거치지 않고 그대로 재사용함. */
+/* struct thread는 init_thread()가 다시 0으로 채우고 스택은 쓰기 전에 */
+/* 읽지 않으므로, 재사용하는 페이지는 0으로 채우지 않음. 실패하면 NULL */
+static struct thread *
+thread_page_alloc (void) {
+	enum intr_level old_level = intr_disable ();
+	struct cpu *c = this_cpu ();
+	struct thread *t = NULL;
+
+	if (0 < c->thread_cache_cnt)
+	{
+		t = c->thread_cache[--c->thread_cache_cnt];
+		c->thread_cache_hits++;
+	}
+	intr_set_level (old_level);
+
+	if (NULL == t)
+	{
+		t = palloc_get_page (PAL_ZERO);
+	}
+
+	return t;
+}
+
+/* 종료된 스레드 T의 페이지를 CPU C의 캐시에 넣고, 캐시가 가득 찼다면 */
+/* 페이지 풀에 돌려줌. C에서 인터럽트를 끈 채로 호출 */
+static void
+thread_page_free (struct cpu *c, struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (THREAD_CACHE_SIZE > c->thread_cache_cnt)
+	{
+		c->thread_cache[c->thread_cache_cnt++] = t;
+	}
+	else
+	{
+		palloc_free_page (t);
 	}
 }
 
 /* Returns a tid to use for a new thread. */
+/* AP의 idle 스레드는 잠들 수 없는 상태에서 tid를 받으므로 락 대신 원자적 연산 사용 */
 static tid_t
 allocate_tid (void) {
 	static tid_t next_tid = 1;
-	tid_t tid;
-
-	lock_acquire (&tid_lock);
-	tid = next_tid++;
-	lock_release (&tid_lock);
 
-	return tid;
+	return __atomic_fetch_add (&next_tid, 1, __ATOMIC_RELAXED);
 }
@@ -0,0 +1,147 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* 유저 공간 동기화를 위한 futex.
+
+   유저 프로그램은 락 워드를 원자적 연산으로만 다루다가, 기다려야 할 때만
+   futex_wait()로, 기다리는 스레드가 있을 수 있을 때만 futex_wake()로 커널에
+   들어옴. 그래서 경쟁이 없는 경로에서는 시스템 콜이 필요 없음.
+
+   대기 큐는 유저 워드의 물리 주소를 키로 하는 해시 테이블에 있음. 같은 물리
+   페이지를 보는 스레드라면 가상 주소가 달라도 같은 큐에서 만남. 큐는 첫
+   대기자가 만들고, 마지막 대기자를 깨울 때 없앰. */
+
+/* 한 워드에서 기다리는 스레드들. */
+struct futex_queue {
+	uint64_t paddr;                     /* 유저 워드의 물리 주소. */
+	struct list waiters;                /* futex_waiter 리스트, 먼저 온 순서. */
+	struct hash_elem elem;              /* futex_queues 원소. */
+};
+
+/* 기다리는 스레드 하나. 그 스레드의 커널 스택에 있음 */
+struct futex_waiter {
+	struct list_elem elem;              /* futex_queue의 waiters 원소. */
+	struct semaphore sema;              /* 깨울 때 올림. */
+};
+
+static struct hash futex_queues;        /* 물리 주소 -> futex_queue. */
+static struct lock futex_lock;          /* futex_queues와 모든 큐를 보호. */
+
+static hash_hash_func queue_hash;
+static hash_less_func queue_less;
+static struct futex_queue *queue_find (uint64_t paddr);
+
+/* futex 대기 큐 테이블을 초기화 */
+void
+futex_init (void) {
+	hash_init (&futex_queues, queue_hash, queue_less, NULL);
+	lock_init (&futex_lock);
+}
+
+/* 커널 주소 KADDR로 보이는 유저 워드가 아직 EXPECTED라면 futex_wake()가 */
+/* 깨울 때까지 잠듦. 깨어났다면 0, 값이 이미 바뀌었거나 큐를 만들 메모리가 */
+/* 없어서 잠들지 않았다면 -1 반환. 값을 확인하는 것과 큐에 들어가는 것이 */
+/* futex_lock 안에서 함께 일어나므로, 값을 바꾼 뒤 futex_wake()를 부르는 */
+/* 스레드와 엇갈려도 깨우기를 놓치지 않음 */
+int
+futex_wait (int *kaddr, int expected) {
+	uint64_t paddr = vtop (kaddr);
+	struct futex_waiter w;
+	struct futex_queue *q;
+
+	lock_acquire (&futex_lock);
+	if (expected != __atomic_load_n (kaddr, __ATOMIC_SEQ_CST))
+	{
+		lock_release (&futex_lock);
+		return -1;
+	}
+
+	q = queue_find (paddr);
+	if (NULL == q)
+	{
+		q = malloc (sizeof *q);
+		if (NULL == q)
+		{
+			lock_release (&futex_lock);
+			return -1;
+		}
+		q->paddr = paddr;
+		list_init (&q->waiters);
+		hash_insert (&futex_queues, &q->elem);
+	}
+
+	sema_init (&w.sema, 0);
+	list_push_back (&q->waiters, &w.elem);
+	lock_release (&futex_lock);
+
+	sema_down (&w.sema);
+	return 0;
+}
+
+/* 커널 주소 KADDR로 보이는 유저 워드에서 기다리는 스레드를 먼저 온 */
+/* 순서대로 최대 N개 깨우고, 깨운 수를 반환 */
+int
+futex_wake (int *kaddr, int n) {
+	struct futex_queue *q;
+	int woken = 0;
+
+	lock_acquire (&futex_lock);
+	q = queue_find (vtop (kaddr));
+	if (NULL != q)
+	{
+		while ((woken < n) && !list_empty (&q->waiters))
+		{
+			struct futex_waiter *w = list_entry (list_pop_front (&q->waiters),
+					struct futex_waiter, elem);
+
+			sema_up (&w->sema);
+			woken++;
+		}
+
+		if (list_empty (&q->waiters))
+		{
+			hash_delete (&futex_queues, &q->elem);
+			free (q);
+		}
+	}
+	lock_release (&futex_lock);
+
+	return woken;
+}
+
+/* 물리 주소 PADDR의 대기 큐. 없다면 NULL. futex_lock을 잡고 있어야 함 */
+static struct futex_queue *
+queue_find (uint64_t paddr) {
+	struct futex_queue key;
+	struct hash_elem *e;
+
+	ASSERT (lock_held_by_current_thread (&futex_lock));
+
+	key.paddr = paddr;
+	e = hash_find (&futex_queues, &key.elem);
+
+	return (NULL != e) ? hash_entry (e, struct futex_queue, elem) : NULL;
+}
+
+/* 대기 큐의 해시 값. 물리 주소로 계산 */
+static uint64_t
+queue_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct futex_queue *q = hash_entry (e, struct futex_queue, elem);
+
+	return hash_bytes (&q->paddr, sizeof q->paddr);
+}
+
+/* 대기 큐 A의 물리 주소가 B보다 작다면 true */
+static bool
+queue_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct futex_queue *a = hash_entry (a_, struct futex_queue, elem);
+	const struct futex_queue *b = hash_entry (b_, struct futex_queue, elem);
+
+	return a->paddr < b->paddr;
+}
@@ -1,5 +1,6 @@
 #include "userprog/gdt.h"
 #include <debug.h>
+#include <string.h>
 #include "userprog/tss.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
@@ -77,10 +78,34 @@ struct desc_ptr gdt_ds = {
 	.address = (uint64_t) gdt
 };
 
+static void gdt_load (struct segment_desc *, struct desc_ptr *);
+
 /* Sets up a proper GDT.  The bootstrap loader's GDT didn't
    include user-mode selectors or a TSS, but we need both now. */
 void
 gdt_init (void) {
+	gdt_load (gdt, &gdt_ds);
+}
+
+/* AP의 GDT를 설정. TSS 디스크립터는 CPU마다 다른 TSS를 가리켜야 하고, */
+/* ltr은 디스크립터를 사용 중(busy)으로 표시하므로 GDT를 CPU마다 따로 둠. */
+/* tss_init_ap() 뒤에 호출 */
+void
+gdt_init_ap (void) {
+	struct segment_desc *ap_gdt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	struct desc_ptr ap_gdt_ds = {
+		.size = sizeof (gdt) - 1,
+		.address = (uint64_t) ap_gdt
+	};
+
+	memcpy (ap_gdt, gdt, sizeof gdt);
+	gdt_load (ap_gdt, &ap_gdt_ds);
+}
+
+/* GDT의 TSS 디스크립터가 현재 CPU의 TSS를 가리키도록 채운 뒤 */
+/* GDT_DS로 GDT를 읽어들이고 세그먼트 레지스터를 다시 읽음 */
+static void
+gdt_load (struct segment_desc *gdt, struct desc_ptr *gdt_ds) {
 	/* Initialize GDT. */
 	struct segment_descriptor64 *tss_desc =
 		(struct segment_descriptor64 *) &gdt[SEL_TSS >> 3];
@@ -105,7 +130,7 @@ gdt_init (void) {
 		.res2 = 0
 	};
 
-	lgdt (&gdt_ds);
+	lgdt (gdt_ds);
 	/* reload segment registers */
 	asm volatile("movw %%ax, %%gs" :: "a" (SEL_UDSEG));
 	asm volatile("movw %%ax, %%fs" :: "a" (0));
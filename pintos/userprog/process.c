@@ -11,8 +11,10 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -28,10 +30,31 @@
 /* filesys.c에 있는 전역 락 */
 extern struct lock filesys_lock;
 
+/* clone()으로 만든 스레드의 유저 스택 크기와, 스택 사이의 간격. */
+/* 스택 아래에 빈 페이지를 두어 넘치면 옆 스택을 덮는 대신 페이지 폴트가 나게 함 */
+#define CLONE_STACK_SIZE PGSIZE
+#define CLONE_STACK_STRIDE (2 * PGSIZE)
+
+/* 한 프로세스가 clone()으로 만들 수 있는 최대 스레드 수. */
+#define CLONE_MAX 64
+
+/* process_clone()이 새 스레드에게 넘기는 정보. 부모의 스택에 있음 */
+struct clone_args {
+	struct thread *parent;              /* clone()을 부른 스레드. */
+	struct intr_frame *if_;             /* 부모의 시스템 콜 프레임. */
+	uint64_t entry;                     /* 새 스레드가 시작할 유저 주소. */
+	uint64_t arg0, arg1;                /* rdi, rsi로 넘길 인자. */
+};
+
 static void process_cleanup (void);
+static struct process *process_create (void);
+static void process_release (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void __do_clone (void *);
+static void *clone_stack_alloc (struct process *);
+static void clone_stack_free (struct process *, void *upage);
 
 /* General process initializer for initd and other process. */
 static void
@@ -39,6 +62,30 @@ process_init (void) {
 	struct thread *current = thread_current ();
 }
 
+/* 현재 스레드 하나만 속한 새 프로세스를 만듦. 메모리가 없다면 NULL */
+static struct process *
+process_create (void) {
+	struct process *proc = calloc (1, sizeof *proc);
+
+	if (NULL == proc)
+	{
+		return NULL;
+	}
+
+	proc->refcnt = 1;
+	proc->pid = thread_current ()->tid;
+	lock_init (&proc->stack_lock);
+#ifdef VM
+	if (!supplemental_page_table_init (&proc->spt))
+	{
+		free (proc);
+		return NULL;
+	}
+#endif
+
+	return proc;
+}
+
 /* Starts the first userland program, called "initd", loaded from FILE_NAME.
  * The new thread may be scheduled (and may even exit)
  * before process_create_initd() returns. Returns the initd's
@@ -87,9 +134,9 @@ process_create_initd (const char *file_name) {
 /* A thread function that launches first user process. */
 static void
 initd (void *f_name) {
-#ifdef VM
-	supplemental_page_table_init (&thread_current ()->spt);
-#endif
+	thread_current ()->proc = process_create ();
+	if (NULL == thread_current ()->proc)
+		PANIC("Fail to launch initd\n");
 
 	process_init ();
 
@@ -113,6 +160,8 @@ process_fork (const char *name, struct intr_frame *if_) {
 	/* 1. 실행 컨텍스트 복제 : 부모 프로세스가 시스템 콜을 호출했을 때의 CPU 상태(레지스터 값 등)가 */
 	/* 담긴 struct intr_frame을 자식에게 복사해줘야 함. 자식의 반환값(rax 레지스터)은 0으로 설정 */
 	cur->parent_if = if_;
+	/* 자식이 복사해갈 수 있도록 레지스터에 있는 FPU 상태를 저장 */
+	fpu_save ();
 
 	/* 2. 프로세스 생성 : 자식 프로세스로 실행될 새로운 커널 스레드를 thread_create 함수로 생성 */
 	tid_t child_tid = thread_create(name, PRI_DEFAULT, __do_fork, cur);
@@ -203,7 +252,7 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	 *    TODO: check whether parent's page is writable or not (set WRITABLE
 	 *    TODO: according to the result). */
 	/* 4. 부모의 페이지 테이블(pml4)을 순회하며 매핑된 모든 유저 메모리 페이지에 대해 새로운 물리 페이지를 할당하고 내용을 복사해야 함. */
-	memcpy(newpage, parent_page, PGSIZE);
+	fpu_copy_page (newpage, parent_page);
 	/* 쓰기 가능 여부 확인 */
 	writable = is_writable(pte);
 
@@ -239,16 +288,22 @@ __do_fork (void *aux) {
 	memcpy (&if_, parent->parent_if, sizeof (struct intr_frame));
 	/* 자식 프로세스의 fork() 반환 값은 0 */
 	if_.R.rax = 0;
+	if (!fpu_fork (current, parent))
+		goto error;
 
 	/* 2. Duplicate PT */
-	current->pml4 = pml4_create();
+	/* fork는 부모의 스레드들과 공유하지 않는 새 프로세스를 만듦 */
+	current->proc = process_create ();
+	if (current->proc == NULL)
+		goto error;
+
+	current->pml4 = current->proc->pml4 = pml4_create();
 	if (current->pml4 == NULL)
 		goto error;
 
 	process_activate (current);
 #ifdef VM
-	supplemental_page_table_init (&current->spt);
-	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
+	if (!supplemental_page_table_copy (&current->proc->spt, &parent->proc->spt))
 		goto error;
 #else
 	if (!pml4_for_each (parent->pml4, duplicate_pte, parent))
@@ -267,19 +322,20 @@ __do_fork (void *aux) {
 	/* file_duplicate()를 호출해야 함. 이러면 파일 내 현재 위치는 독립적으로 관리 가능 */
 	for (int i = 0; i < FDT_COUNT_LIMIT; ++i)
 	{
-		if (NULL != parent->fd_table[i])
+		if (NULL != parent->proc->fd_table[i])
 		{
 			/* file_duplicate는 같은 inode를 공유하지만 별도의 file 객체 생성 */
-			current->fd_table[i] = file_duplicate(parent->fd_table[i]);
+			current->proc->fd_table[i] = file_duplicate(parent->proc->fd_table[i]);
 
-			if (NULL == current->fd_table[i])
+			if (NULL == current->proc->fd_table[i])
 			{
 				/* 실패 시, 이미 복제된 열린 파일들을 모두 닫음 */
 				for (int j = 0; j < i; ++j)
 				{
-					if (NULL != current->fd_table[j])
+					if (NULL != current->proc->fd_table[j])
 					{
-						file_close(current->fd_table[j]);
+						file_close(current->proc->fd_table[j]);
+						current->proc->fd_table[j] = NULL;
 					}
 				}
 
@@ -309,6 +365,178 @@ error:
 	thread_exit ();
 }
 
+/* 현재 프로세스 안에 NAME이라는 스레드를 새로 만듦. 새 스레드는 같은 */
+/* 페이지 테이블과 파일 디스크립터 테이블을 쓰고, 자신만의 유저 스택 위에서 */
+/* rdi = ARG0, rsi = ARG1로 유저 주소 ENTRY부터 실행함. */
+/* 새 스레드도 자식으로 등록되므로 process_wait()으로 끝나기를 기다릴 수 있음. */
+/* 새 스레드의 tid를 반환하고, 만들 수 없다면 TID_ERROR */
+tid_t
+process_clone (const char *name, struct intr_frame *if_,
+		uint64_t entry, uint64_t arg0, uint64_t arg1) {
+	struct thread *cur = thread_current ();
+	struct clone_args args = {
+		.parent = cur,
+		.if_ = if_,
+		.entry = entry,
+		.arg0 = arg0,
+		.arg1 = arg1,
+	};
+	struct thread *child = NULL;
+	struct list_elem *e;
+	tid_t child_tid;
+
+	/* 새 스레드가 실행되기 전에 프로세스가 사라지지 않도록 미리 참조를 늘림 */
+	__atomic_add_fetch (&cur->proc->refcnt, 1, __ATOMIC_SEQ_CST);
+
+	child_tid = thread_create (name, thread_get_priority (), __do_clone, &args);
+	if (TID_ERROR == child_tid)
+	{
+		__atomic_sub_fetch (&cur->proc->refcnt, 1, __ATOMIC_SEQ_CST);
+		return TID_ERROR;
+	}
+
+	/* fork와 같이 새 스레드가 준비를 마칠 때까지 기다림. */
+	/* ARGS가 이 스택에 있으므로 그 전에 돌아가면 안 됨 */
+	for (e = list_begin (&cur->child_list); e != list_end (&cur->child_list); e = list_next (e))
+	{
+		struct thread *t = list_entry (e, struct thread, child_elem);
+
+		if (child_tid == t->tid)
+		{
+			child = t;
+			sema_down (&child->fork_sema);
+			break;
+		}
+	}
+
+	if ((NULL == child) || (-1 == child->exit_status))
+	{
+		process_wait (child_tid);
+		return TID_ERROR;
+	}
+
+	return child_tid;
+}
+
+/* process_clone()으로 만든 스레드의 첫 함수. 부모의 프로세스에 합류해 */
+/* 유저 스택을 받은 뒤 유저 모드로 넘어감 */
+static void
+__do_clone (void *aux) {
+	struct clone_args *args = aux;
+	struct thread *current = thread_current ();
+	struct intr_frame if_;
+	void *stack;
+
+	/* 세그먼트와 플래그는 부모가 시스템 콜로 들어올 때의 것을 그대로 씀 */
+	memcpy (&if_, args->if_, sizeof if_);
+
+	/* 참조는 process_clone()이 이미 늘려 두었음 */
+	current->proc = args->parent->proc;
+	current->pml4 = current->proc->pml4;
+	process_activate (current);
+
+	stack = clone_stack_alloc (current->proc);
+	if (NULL == stack)
+	{
+		current->exit_status = -1;
+		sema_up (&current->fork_sema);
+		thread_exit ();
+	}
+	current->user_stack = stack;
+
+	if_.rip = args->entry;
+	if_.R.rdi = args->arg0;
+	if_.R.rsi = args->arg1;
+	if_.R.rax = 0;
+	/* 함수에 막 들어온 것처럼 스택에 가짜 반환 주소 자리를 남김 */
+	if_.rsp = (uint64_t) stack + CLONE_STACK_SIZE - sizeof (uint64_t);
+
+	/* 이 뒤로는 ARGS를 읽지 않음 */
+	sema_up (&current->fork_sema);
+
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* clone 스택 자리 I(1부터 CLONE_MAX까지)의 유저 주소 */
+#define CLONE_STACK_VA(I) \
+	((uint8_t *) USER_STACK - CLONE_STACK_SIZE - (I) * CLONE_STACK_STRIDE)
+
+/* 프로세스 PROC에서 쓰지 않는 스택 자리를 골라 그 유저 주소를 반환. */
+/* 자리나 메모리가 없다면 NULL. */
+/* 스택은 프로세스의 처음 스택 아래로 CLONE_STACK_STRIDE 간격으로 놓임. */
+/* 끝난 스레드가 쓰던 자리는 매핑된 채로 남아있으므로 그 페이지를 그대로 다시 쓰고, */
+/* 처음 쓰는 자리에만 0으로 채운 페이지를 매핑함 */
+static void *
+clone_stack_alloc (struct process *proc) {
+	void *upage = NULL;
+
+	lock_acquire (&proc->stack_lock);
+	for (int i = 1; i <= CLONE_MAX; ++i)
+	{
+		uint64_t bit = (uint64_t) 1 << (i - 1);
+		void *va = CLONE_STACK_VA (i);
+
+		if (0 != (proc->stack_map & bit))
+		{
+			continue;
+		}
+
+#ifdef VM
+		if ((NULL != spt_find_page (&proc->spt, va))
+				|| (vm_alloc_page (VM_ANON | VM_MARKER_0, va, true) && vm_claim_page (va)))
+		{
+			upage = va;
+		}
+#else
+		if (NULL != pml4_get_page (proc->pml4, va))
+		{
+			upage = va;
+		}
+		else
+		{
+			void *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+
+			if ((NULL != kpage) && pml4_set_page (proc->pml4, va, kpage, true))
+			{
+				upage = va;
+			}
+			else if (NULL != kpage)
+			{
+				palloc_free_page (kpage);
+			}
+		}
+#endif
+		if (NULL != upage)
+		{
+			proc->stack_map |= bit;
+		}
+		break;
+	}
+	lock_release (&proc->stack_lock);
+
+	return upage;
+}
+
+/* 프로세스 PROC에서 clone_stack_alloc()으로 받은 스택 UPAGE를 돌려줌. */
+/* 그 스택을 쓰던 스레드는 이미 커널에 들어와 있어야 함. */
+/* 같은 프로세스의 스레드가 다른 CPU에서 돌고 있다면 그 CPU의 TLB에 이 스택의 */
+/* 항목이 남아있을 수 있으므로 페이지는 해제하지 않고 자리만 비움. */
+/* 페이지는 다음 clone()이 다시 쓰거나, 모든 스레드가 페이지 테이블에서 */
+/* 떠난 뒤 주소 공간과 함께 해제됨 */
+static void
+clone_stack_free (struct process *proc, void *upage) {
+	int i = ((uint8_t *) USER_STACK - CLONE_STACK_SIZE - (uint8_t *) upage)
+		/ CLONE_STACK_STRIDE;
+
+	ASSERT (1 <= i && i <= CLONE_MAX);
+	ASSERT (CLONE_STACK_VA (i) == upage);
+
+	lock_acquire (&proc->stack_lock);
+	proc->stack_map &= ~((uint64_t) 1 << (i - 1));
+	lock_release (&proc->stack_lock);
+}
+
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 /* 새로 만들어진 스레드가 CPU를 할당받아 처음으로 실행하는 함수 */
@@ -319,6 +547,14 @@ process_exec (void *f_name) {
 	char *file_name = f_name;
 	bool success;
 
+	/* 같은 주소 공간에서 다른 스레드가 돌고 있다면 그 스레드들의 코드와 */
+	/* 스택을 지울 수 없으므로 실패 */
+	if (1 < __atomic_load_n (&thread_current ()->proc->refcnt, __ATOMIC_SEQ_CST))
+	{
+		palloc_free_page (file_name);
+		return -1;
+	}
+
 	/* We cannot use the intr_frame in the thread structure.
 	 * This is because when current thread rescheduled,
 	 * it stores the execution information to the member. */
@@ -331,6 +567,13 @@ process_exec (void *f_name) {
 	 * 새로운 프로그램을 로드하기 전에, 현재 프로세스의 주소 공간과 리소스를 정리합니다. */
 	process_cleanup ();
 
+	/* clone 스택은 주소 공간과 함께 사라졌음 */
+	thread_current ()->user_stack = NULL;
+	thread_current ()->proc->stack_map = 0;
+
+	/* 이전 프로그램의 FPU 레지스터 값이 새 프로그램에 넘어가지 않도록 버림 */
+	fpu_reset ();
+
 	/* And then load the binary */
 	/* 디스크에서 메모리로 이진 파일 로드 */
 	/* 다음에 실행될 명령어 주소(유저 프로그램의 첫 실행 명령어 주소)와 */
@@ -421,7 +664,11 @@ process_exit (void) {
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
 	/* 프로세스 종료 메시지 출력. 모든 종료 경로를 처리할 수 있음. */
-	printf("%s: exit(%d)\n", curr->name, curr->exit_status);
+	/* clone()으로 만든 스레드는 프로세스가 아니므로 출력하지 않음 */
+	if ((NULL == curr->proc) || (curr->proc->pid == curr->tid))
+	{
+		printf("%s: exit(%d)\n", curr->name, curr->exit_status);
+	}
 
 	/* 부모가 먼저 종료될 때, 자식 프로세스들이 고아가 되어 영원히 대기하는 것 방지 */
 	/* 부모의 자식 리스트 순회해 각 자식이 스스로 종료될 수 있도록 free_sema를 올려줌. */
@@ -437,37 +684,91 @@ process_exit (void) {
 		/* 자식이 부모의 wait 호출 없이도 종료될 수 있도록 함 */
 		sema_up(&child->free_sema);
 	}
+
+	/* 프로세스 자원은 부모를 깨우기 전에 정리해서, wait()에서 돌아온 부모가 */
+	/* 실행 파일에 쓸 수 있게 함. */
+	/* exit()는 부른 스레드만 끝냄. 처음 스레드가 끝나면 부모의 wait()은 그 종료 */
+	/* 상태를 받아 바로 돌아오지만, clone()으로 만든 스레드가 남아있다면 그 */
+	/* 스레드들은 계속 돌고 주소 공간, 열린 파일과 실행 파일은 마지막 스레드가 */
+	/* 끝날 때 해제됨. 처음 스레드는 끝나기 전에 wait()으로 자신이 만든 스레드를 */
+	/* 모두 기다려야 함 */
+	process_release ();
 	
-	/* 프로세스 종료될 때, 열려있는 모든 파일 닫아야 함. */
+	if (NULL != curr->parent)
+	{
+		/* 자식 프로세스는 process_wait에서 잠들어 있는 부모를 깨우는 동기화 작업을 수행해야 함. */
+		/* process_wait에서 sema_down 시킨 wait_sema를 sema_up 해 부모를 깨움. */
+		sema_up(&curr->wait_sema);
+
+		/* 부모가 자신의 상태를 모두 읽고 신호를 보내줄 때까지 대기 */
+		/* 부모에서 sema_up을 수행시켜줘야 자식은 메모리에서 해제될 수 있음. */
+		sema_down(&curr->free_sema);	
+	}
+}
+
+/* 현재 스레드를 자신의 프로세스에서 떼어냄. 마지막 스레드였다면 열린 파일을 */
+/* 닫고 주소 공간과 프로세스를 해제하고, 아니라면 자신의 유저 스택만 돌려줌 */
+static void
+process_release (void) {
+	struct thread *curr = thread_current ();
+	struct process *proc = curr->proc;
+
+	if (NULL == proc)
+	{
+		/* fork가 프로세스를 만들기 전에 실패했을 수도 있음 */
+		process_cleanup ();
+		return;
+	}
+
+	/* 참조를 놓은 뒤에는 다른 스레드가 PROC을 해제할 수 있으므로 스택을 먼저 돌려줌 */
+	if (NULL != curr->user_stack)
+	{
+		clone_stack_free (proc, curr->user_stack);
+		curr->user_stack = NULL;
+	}
+
+	/* 참조를 놓은 순간 마지막 스레드가 다른 CPU에서 페이지 테이블을 해제할 수 */
+	/* 있으므로, 그 전에 이 CPU를 커널 페이지 테이블로 옮김. */
+	/* process_cleanup()과 같은 이유로 NULL로 바꾼 뒤에 전환함 */
+	uint64_t *pml4 = curr->pml4;
+	curr->pml4 = NULL;
+	pml4_activate (NULL);
+
+	if (0 < __atomic_sub_fetch (&proc->refcnt, 1, __ATOMIC_SEQ_CST))
+	{
+		/* 페이지 테이블은 남은 스레드가 계속 쓰므로 이 스레드만 떼어냄 */
+		curr->proc = NULL;
+		return;
+	}
+
+	/* 마지막 스레드이므로 페이지 테이블을 다시 가져와 아래에서 해제함 */
+	curr->pml4 = pml4;
+	pml4_activate (pml4);
+
+	/* 프로세스가 종료될 때, 열려있는 모든 파일 닫아야 함. */
 	lock_acquire(&filesys_lock);
 	for (int i = 2; i < FDT_COUNT_LIMIT; ++i)
 	{
-		if (NULL != curr->fd_table[i])
+		if (NULL != proc->fd_table[i])
 		{
-			file_close(curr->fd_table[i]);
+			file_close(proc->fd_table[i]);
 		}
 	}
 
 	/* 실행 중인 파일 닫기 */
-	if (NULL != curr->exec_file)
+	if (NULL != proc->exec_file)
 	{
-		file_close(curr->exec_file);
+		file_close(proc->exec_file);
 	}
 
 	lock_release(&filesys_lock);
 
-	if (NULL != curr->parent)
-	{
-		/* 자식 프로세스는 process_wait에서 잠들어 있는 부모를 깨우는 동기화 작업을 수행해야 함. */
-		/* process_wait에서 sema_down 시킨 wait_sema를 sema_up 해 부모를 깨움. */
-		sema_up(&curr->wait_sema);
-
-		/* 부모가 자신의 상태를 모두 읽고 신호를 보내줄 때까지 대기 */
-		/* 부모에서 sema_up을 수행시켜줘야 자식은 메모리에서 해제될 수 있음. */
-		sema_down(&curr->free_sema);	
-	}
-
 	process_cleanup ();
+	curr->proc = NULL;
+#ifdef VM
+	supplemental_page_table_destroy (&proc->spt);
+#endif
+	free (proc);
 }
 
 /* Free the current process's resources. */
@@ -476,7 +777,10 @@ process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
 #ifdef VM
-	supplemental_page_table_kill (&curr->spt);
+	if (NULL != curr->proc)
+	{
+		supplemental_page_table_kill (&curr->proc->spt);
+	}
 #endif
 
 	uint64_t *pml4;
@@ -492,6 +796,10 @@ process_cleanup (void) {
 		 * directory, or our active page directory will be one
 		 * that's been freed (and cleared). */
 		curr->pml4 = NULL;
+		if (NULL != curr->proc)
+		{
+			curr->proc->pml4 = NULL;
+		}
 		pml4_activate (NULL);
 		pml4_destroy (pml4);
 	}
@@ -587,7 +895,7 @@ load (const char *file_name, struct intr_frame *if_) {
 
 	/* Allocate and activate page directory. */
 	/* 프로세스 고유의 페이지 디렉토리를 생성 */
-	t->pml4 = pml4_create ();
+	t->pml4 = t->proc->pml4 = pml4_create ();
 	if (t->pml4 == NULL)
 	{
 		return false;
@@ -792,7 +1100,7 @@ load (const char *file_name, struct intr_frame *if_) {
 	success = true;
 
 	/* 실행 파일을 스레드에 저장 */
-	t->exec_file = file;
+	t->proc->exec_file = file;
 	/* 성공 시 파일 닫기를 건너뜀 */
 	goto release_done;
 
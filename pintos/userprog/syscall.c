@@ -1,6 +1,7 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
 #include <syscall-nr.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
@@ -14,6 +15,8 @@
 #include "filesys/filesys.h"
 #include "filesys/file.h"
 #include "userprog/process.h"
+#include "devices/input.h"
+#include "userprog/futex.h"
 
 /* 함수 포인터 타입 정의 */
 typedef void syscall_handler_func(struct intr_frame* f);
@@ -24,6 +27,9 @@ extern struct lock filesys_lock;
 /* 함수 포인터 배열 선언 */
 static syscall_handler_func* syscall_handlers[SYS_END];
 
+/* 유저 프로그램이 실시간 클래스를 쓸 수 있는지 여부 */
+bool user_rt_allowed;
+
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
 
@@ -45,10 +51,14 @@ void sys_remove(struct intr_frame* f);
 void sys_create(struct intr_frame* f);
 void sys_fork(struct intr_frame* f);
 void sys_seek(struct intr_frame* f);
+void sys_sched_setclass(struct intr_frame* f);
+void sys_futex_wait(struct intr_frame* f);
+void sys_futex_wake(struct intr_frame* f);
 
 /* syscall3 */
 void sys_write(struct intr_frame* f);
 void sys_read(struct intr_frame* f);
+void sys_clone(struct intr_frame* f);
 
 /* 유효 주소 검사 헬퍼 함수 */
 void check_address(void* addr);
@@ -67,9 +77,11 @@ void check_valid_string(const char* str);
 #define MSR_STAR 0xc0000081         /* Segment selector msr */
 #define MSR_LSTAR 0xc0000082        /* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
+#define MSR_KERNEL_GS_BASE 0xc0000102 /* swapgs가 %gs 기준 주소와 맞바꾸는 값 */
 
-void
-syscall_init (void) {
+/* 현재 CPU가 syscall 명령을 받도록 MSR을 설정 */
+static void
+syscall_init_msr (void) {
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48  |
 			((uint64_t)SEL_KCSEG) << 32);
 	write_msr(MSR_LSTAR, (uint64_t) syscall_entry);
@@ -80,6 +92,22 @@ syscall_init (void) {
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 
+	/* syscall_entry는 swapgs로 이 CPU의 struct cpu를 %gs에 얻어 */
+	/* 임시 저장 공간과 TSS를 찾음 */
+	write_msr(MSR_KERNEL_GS_BASE, (uint64_t) this_cpu ());
+}
+
+/* AP가 syscall 명령을 받도록 설정 */
+void
+syscall_init_ap (void) {
+	syscall_init_msr ();
+}
+
+void
+syscall_init (void) {
+	syscall_init_msr ();
+	futex_init ();
+
 	/* Project 2 */
 	syscall_handlers[SYS_HALT] = sys_halt;
 	syscall_handlers[SYS_EXIT] = sys_exit;
@@ -112,6 +140,14 @@ syscall_init (void) {
 	syscall_handlers[SYS_DUP2] = NULL;
 	syscall_handlers[SYS_MOUNT] = NULL;
 	syscall_handlers[SYS_UMOUNT] = NULL;
+
+	/* 스케줄링 */
+	syscall_handlers[SYS_SCHED_SETCLASS] = sys_sched_setclass;
+	syscall_handlers[SYS_CLONE] = sys_clone;
+
+	/* 유저 공간 동기화 */
+	syscall_handlers[SYS_FUTEX_WAIT] = sys_futex_wait;
+	syscall_handlers[SYS_FUTEX_WAKE] = sys_futex_wake;
 }
 
 /* The main system call interface */
@@ -246,8 +282,10 @@ void sys_open(struct intr_frame* f)
 	/* 4. 열기 성공 시, 파일 식별자 할당 후 반환 */
 	/* 0, 1은 표준 입출력이므로 2부터 사용 가능 */
 	/* 2부터 시작해 비어있는 fd 테이블 슬롯 찾기 */
+	/* clone()으로 만든 스레드들이 테이블을 공유하므로 찾기와 채우기를 락 안에서 함 */
+	lock_acquire(&filesys_lock);
 	int fd = 2;
-	while ((FDT_COUNT_LIMIT > fd) && (NULL != cur->fd_table[fd]))
+	while ((FDT_COUNT_LIMIT > fd) && (NULL != cur->proc->fd_table[fd]))
 	{
 		++fd;
 	}
@@ -255,7 +293,6 @@ void sys_open(struct intr_frame* f)
 	/* 테이블 전부 사용 시 파일 닫고 실패 반환 */
 	if (FDT_COUNT_LIMIT <= fd)
 	{
-		lock_acquire(&filesys_lock);
 		file_close(open_file);
 		lock_release(&filesys_lock);
 
@@ -263,7 +300,8 @@ void sys_open(struct intr_frame* f)
 		return;
 	}
 	
-	cur->fd_table[fd] = open_file;
+	cur->proc->fd_table[fd] = open_file;
+	lock_release(&filesys_lock);
 
 	f->R.rax = fd;
 }
@@ -282,20 +320,27 @@ void sys_close(struct intr_frame* f)
 	/* 1. 인자(fd) 검증 : 파일 디스크립터가 유효한지 확인 */
 	/* fd가 유효한 범위 내에 있는지 (2 이상 FDT_COUNT_LIMIT 미만) */
 	/* 해당 fd가 실제 열려 있는 파일을 가리키고 있는지 (파일 디스크립터 테이블의 해당 슬롯이 NULL이 아닌지) */
-	if ((2 > fd) || (FDT_COUNT_LIMIT <= fd) || (NULL == cur->fd_table[fd]))
+	/* 같은 테이블을 쓰는 다른 스레드가 같은 fd를 함께 닫지 않도록 슬롯 검사부터 락 안에서 함 */
+	struct file* target_file = NULL;
+	lock_acquire(&filesys_lock);
+	if ((2 <= fd) && (FDT_COUNT_LIMIT > fd))
+	{
+		target_file = cur->proc->fd_table[fd];
+	}
+
+	if (NULL == target_file)
 	{
+		lock_release(&filesys_lock);
 		cur->exit_status = -1;
 
 		thread_exit();
 	}
 
 	/* 2. 파일 닫기 : 파일 디스크립터 테이블에서 파일 객체 포인터를 가져와 file_close() 호출 */
-	lock_acquire(&filesys_lock);
-	file_close(cur->fd_table[fd]);
-	lock_release(&filesys_lock);
-
 	/* 3. 테이블 정리 : 파일 디스크립터 테이블의 해당 슬롯을 NULL로 설정해 fd가 비어있음을 표시 */
-	cur->fd_table[fd] = NULL;
+	cur->proc->fd_table[fd] = NULL;
+	file_close(target_file);
+	lock_release(&filesys_lock);
 }
 
 /* 열려 있는 파일의 크기를 바이트 단위로 알려주는 시스템 콜 */
@@ -306,15 +351,24 @@ void sys_filesize(struct intr_frame* f)
 	struct thread* cur = thread_current();
 
 	/* 1. fd 유효성 검사 */
-	if ((2 > fd) || (FDT_COUNT_LIMIT <= fd) || (NULL == cur->fd_table[fd]))
+	if ((2 > fd) || (FDT_COUNT_LIMIT <= fd))
 	{
 		f->R.rax = -1;
 		return;
 	}
 
-	/* 2. 파일 크기 반환 - file_length() 함수 호출 */
+	/* 다른 스레드가 같은 fd를 닫을 수 있으므로 슬롯은 락 안에서 한 번만 읽음 */
 	lock_acquire(&filesys_lock);
-	int size = file_length(cur->fd_table[fd]);
+	struct file* target_file = cur->proc->fd_table[fd];
+	if (NULL == target_file)
+	{
+		lock_release(&filesys_lock);
+		f->R.rax = -1;
+		return;
+	}
+
+	/* 2. 파일 크기 반환 - file_length() 함수 호출 */
+	int size = file_length(target_file);
 	lock_release(&filesys_lock);
 
 	f->R.rax = size;
@@ -372,17 +426,23 @@ void sys_tell(struct intr_frame* f)
 	struct thread* cur = thread_current();
 
 	/* 1. fd 유효성 검사 */
-	if ((2 > fd) || (FDT_COUNT_LIMIT <= fd) || (NULL == cur->fd_table[fd]))
+	/* tell은 값을 반환해야 하므로 실패 시 -1 반환 */
+	if ((2 > fd) || (FDT_COUNT_LIMIT <= fd))
 	{
-		/* tell은 값을 반환해야 하므로 실패 시 -1 반환 */
 		f->R.rax = -1;
 		return;
 	}
 
-	struct file* target_file = cur->fd_table[fd];
+	lock_acquire(&filesys_lock);
+	struct file* target_file = cur->proc->fd_table[fd];
+	if (NULL == target_file)
+	{
+		lock_release(&filesys_lock);
+		f->R.rax = -1;
+		return;
+	}
 
 	/* 2. 파일 위치 반환(file_tell 호출) */
-	lock_acquire(&filesys_lock);
 	unsigned int position = file_tell(target_file);
 	lock_release(&filesys_lock);
 
@@ -461,21 +521,25 @@ void sys_seek(struct intr_frame* f)
 	struct thread* cur = thread_current();
 
 	/* 1. fd 유효성 검사 */
-	if ((2 > fd) || (FDT_COUNT_LIMIT <= fd) || (NULL == cur->fd_table[fd]))
+	struct file* target_file = NULL;
+	lock_acquire(&filesys_lock);
+	if ((2 <= fd) && (FDT_COUNT_LIMIT > fd))
+	{
+		target_file = cur->proc->fd_table[fd];
+	}
+
+	if (NULL == target_file)
 	{
+		lock_release(&filesys_lock);
+
 		/* 유효하지 않은 fd라면 프로세스 종료 */
 		cur->exit_status = -1;
 
 		/* 현재 커널 스레드 종료. 한 프로세스가 한 커널 스레드 위에서 동작시키기 때문에 프로세스 종료 */
 		thread_exit();
-
-		return;
 	}
 
-	struct file* target_file = cur->fd_table[fd];
-
 	/* 2. 파일 위치 이동(file_seek 호출) */
-	lock_acquire(&filesys_lock);
 	file_seek(target_file, pos);
 	lock_release(&filesys_lock);
 }
@@ -513,17 +577,15 @@ void sys_write(struct intr_frame* f)
 	/* 일반 파일 처리(fd > 1) */
 	else if ((STDOUT_FILENO < fd) && (FDT_COUNT_LIMIT > fd))
 	{
-		struct file* open_file = thread_current()->fd_table[fd];
+		/* 다른 스레드가 같은 fd를 닫을 수 있으므로 슬롯은 락 안에서 한 번만 읽음 */
+		lock_acquire(&filesys_lock);
+		struct file* open_file = thread_current()->proc->fd_table[fd];
 
 		/* 열린 적 없는 파일이라면 -1 반환 */
-		if (NULL == open_file)
+		if (NULL != open_file)
 		{
-			f->R.rax = -1;
-			return;
+			bytes_write = file_write(open_file, buffer, size);
 		}
-
-		lock_acquire(&filesys_lock);
-		bytes_write = file_write(open_file, buffer, size);
 		lock_release(&filesys_lock);
 	}
 	
@@ -556,32 +618,97 @@ void sys_read(struct intr_frame* f)
 	/* 2. 표준 입력(키보드)으로부터 읽기 */
 	if (STDIN_FILENO == fd)
 	{
-		char* local_buf = (char*)buffer;
-
-		/* size와 타입을 맞춰주기 위함. */
-		for (unsigned int i = 0; i < size; ++i)
-		{
-			local_buf[i] = input_getc();
-		}
+		/* 이미 들어와 있는 키는 한 번에 가져옴 */
+		input_read(buffer, size);
 
 		bytes_read = size;
 	}
 	/* 3. 일반 파일으로부터 읽기 */
 	else if ((STDOUT_FILENO < fd) && (FDT_COUNT_LIMIT > fd))
 	{
-		struct thread* cur = thread_current();
+		/* 다른 스레드가 같은 fd를 닫을 수 있으므로 슬롯은 락 안에서 한 번만 읽음 */
+		lock_acquire(&filesys_lock);
+		struct file* open_file = thread_current()->proc->fd_table[fd];
 
-		if (NULL == cur->fd_table[fd])
+		/* 열린 적 없는 파일이라면 -1 반환 */
+		if (NULL != open_file)
 		{
-			f->R.rax = -1;
-			return;
+			bytes_read = file_read(open_file, buffer, size);
 		}
-
-		lock_acquire(&filesys_lock);
-		bytes_read = file_read(cur->fd_table[fd], buffer, size);
 		lock_release(&filesys_lock);
 	}
 
 	/* 그 외의 fd는 유효하지 않으므로 -1 반환 */
 	f->R.rax = bytes_read;
-}
\ No newline at end of file
+}
+
+/* 현재 스레드의 스케줄링 클래스와 클래스 안의 우선순위를 바꾸는 시스템 콜 */
+/* 성공하면 0, 클래스나 우선순위가 범위를 벗어나면 -1 반환. */
+/* 실시간 클래스의 스레드는 양보하기 전까지 보통 스레드에게 CPU를 넘기지 */
+/* 않으므로, SCHED_FIFO와 SCHED_RR은 "-user-rt"로 부팅했을 때만 고를 수 있고 */
+/* 그렇지 않다면 -1 반환 */
+void sys_sched_setclass(struct intr_frame* f)
+{
+	enum sched_class cls = (enum sched_class)f->R.rdi;
+	int priority = (int)f->R.rsi;
+
+	if (!user_rt_allowed && ((SCHED_FIFO == cls) || (SCHED_RR == cls)))
+	{
+		f->R.rax = -1;
+		return;
+	}
+
+	f->R.rax = thread_set_class(cls, priority) ? 0 : -1;
+}
+
+/* futex 시스템 콜이 받은 유저 워드 주소를 검사하고 커널 주소로 바꾸는 함수 */
+/* 매핑되지 않은 주소라면 프로세스를 종료하고, 워드 경계에 맞지 않는다면 NULL 반환 */
+/* 경계에 맞는 워드는 페이지 경계를 넘지 않으므로 한 페이지만 확인하면 됨 */
+static int* futex_word(int* addr)
+{
+	check_address(addr);
+
+	if (0 != ((uint64_t)addr % sizeof(int)))
+	{
+		return NULL;
+	}
+
+	return pml4_get_page(thread_current()->pml4, addr);
+}
+
+/* 유저 워드 ADDR의 값이 EXPECTED인 동안 잠드는 시스템 콜 */
+/* 깨어났다면 0, 값이 이미 바뀌었거나 주소가 워드 경계에 맞지 않다면 -1 반환 */
+void sys_futex_wait(struct intr_frame* f)
+{
+	int* word = futex_word((int*)f->R.rdi);
+	int expected = (int)f->R.rsi;
+
+	f->R.rax = (NULL != word) ? futex_wait(word, expected) : -1;
+}
+
+/* 유저 워드 ADDR에서 기다리는 스레드를 최대 N개 깨우는 시스템 콜 */
+/* 깨운 스레드 수, 주소가 워드 경계에 맞지 않다면 -1 반환 */
+void sys_futex_wake(struct intr_frame* f)
+{
+	int* word = futex_word((int*)f->R.rdi);
+	int n = (int)f->R.rsi;
+
+	f->R.rax = (NULL != word) ? futex_wake(word, n) : -1;
+}
+
+/* 현재 프로세스의 주소 공간과 파일 디스크립터 테이블을 공유하는 스레드를 만드는 시스템 콜 */
+/* 새 스레드는 자신의 유저 스택 위에서 ENTRY(ARG0, ARG1)부터 실행됨 */
+/* 새 스레드의 tid, 실패 시 -1 반환. 돌려받은 tid로 wait()하면 스레드가 끝나기를 기다림 */
+void sys_clone(struct intr_frame* f)
+{
+	uint64_t entry = f->R.rdi;
+
+	/* 유저 영역이 아닌 곳에서 시작하려 한다면 스레드를 만들지 않음 */
+	if (!is_user_vaddr((void*)entry))
+	{
+		f->R.rax = -1;
+		return;
+	}
+
+	f->R.rax = process_clone(thread_name(), f, entry, f->R.rsi, f->R.rdx);
+}
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "threads/cpu.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -46,7 +47,8 @@
  *      (The call is in schedule in thread.c.) */
 
 /* Kernel TSS. */
-struct task_state *tss;
+/* CPU마다 하나씩 있으며 struct cpu의 tss가 가리킴. */
+/* 각 CPU는 자신이 실행 중인 스레드의 커널 스택을 rsp0에 둠 */
 
 /* Initializes the kernel TSS. */
 void
@@ -54,13 +56,22 @@ tss_init (void) {
 	/* Our TSS is never used in a call gate or task gate, so only a
 	 * few fields of it are ever referenced, and those are the only
 	 * ones we initialize. */
-	tss = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	this_cpu ()->tss = palloc_get_page (PAL_ASSERT | PAL_ZERO);
 	tss_update (thread_current ());
 }
 
+/* AP의 TSS를 만듦. thread_init_ap() 뒤에 호출 */
+void
+tss_init_ap (void) {
+	tss_init ();
+}
+
 /* Returns the kernel TSS. */
+/* 현재 CPU의 TSS를 반환 */
 struct task_state *
 tss_get (void) {
+	struct task_state *tss = this_cpu ()->tss;
+
 	ASSERT (tss != NULL);
 	return tss;
 }
@@ -69,6 +80,5 @@ tss_get (void) {
  * of the thread stack. */
 void
 tss_update (struct thread *next) {
-	ASSERT (tss != NULL);
-	tss->rsp0 = (uint64_t) next + PGSIZE;
+	tss_get ()->rsp0 = (uint64_t) next + PGSIZE;
 }
@@ -1,8 +1,11 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
+#include <string.h>
 #include "threads/malloc.h"
+#include "threads/vaddr.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
+#include "userprog/process.h"
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -36,6 +39,15 @@ page_get_type (struct page *page) {
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
 static struct frame *vm_evict_frame (void);
+static struct page *spt_lookup (struct supplemental_page_table *, uintptr_t va);
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+static size_t run_search (const struct supplemental_page_table *, uintptr_t va);
+static bool run_reserve (struct supplemental_page_table *, size_t cnt);
+static bool run_add (struct supplemental_page_table *, uintptr_t va);
+static void run_cut (struct supplemental_page_table *, uintptr_t lo,
+		uintptr_t hi);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -46,7 +58,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 
 	ASSERT (VM_TYPE(type) != VM_UNINIT)
 
-	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct supplemental_page_table *spt = &thread_current ()->proc->spt;
 
 	/* Check wheter the upage is already occupied or not. */
 	if (spt_find_page (spt, upage) == NULL) {
@@ -61,30 +73,244 @@ err:
 }
 
 /* Find VA from spt and return page. On error, return NULL. */
+/* VA는 페이지 안의 아무 주소나 됨 */
 struct page *
-spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
-	struct page *page = NULL;
-	/* TODO: Fill this function. */
+spt_find_page (struct supplemental_page_table *spt, void *va) {
+	struct page *page;
+
+	rwlock_acquire_read (&spt->lock);
+	page = spt_lookup (spt, (uintptr_t) pg_round_down (va));
+	rwlock_release_read (&spt->lock);
 
 	return page;
 }
 
 /* Insert PAGE into spt with validation. */
+/* 같은 주소의 페이지가 이미 있거나 메모리가 부족하면 false */
 bool
-spt_insert_page (struct supplemental_page_table *spt UNUSED,
-		struct page *page UNUSED) {
-	int succ = false;
-	/* TODO: Fill this function. */
+spt_insert_page (struct supplemental_page_table *spt, struct page *page) {
+	bool succ = false;
+
+	ASSERT (pg_ofs (page->va) == 0);
+
+	rwlock_acquire_write (&spt->lock);
+	if (hash_insert (&spt->pages, &page->spt_elem) == NULL) {
+		succ = run_add (spt, (uintptr_t) page->va);
+		if (!succ)
+			hash_delete (&spt->pages, &page->spt_elem);
+	}
+	rwlock_release_write (&spt->lock);
 
 	return succ;
 }
 
+/* PAGE를 spt에서 빼고 해제 */
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
+	uintptr_t va = (uintptr_t) page->va;
+
+	rwlock_acquire_write (&spt->lock);
+	if (hash_delete (&spt->pages, &page->spt_elem) != NULL)
+		run_cut (spt, va, va + PGSIZE);
+	rwlock_release_write (&spt->lock);
+
 	vm_dealloc_page (page);
+}
+
+/* START부터 PAGE_CNT 페이지 안에 매핑된 페이지가 있다면 true.
+ * mmap이 기존 매핑과 겹치는지 검사할 때 씀 */
+bool
+spt_overlaps (struct supplemental_page_table *spt, void *start,
+		size_t page_cnt) {
+	uintptr_t lo = (uintptr_t) start;
+	uintptr_t hi = lo + page_cnt * PGSIZE;
+	bool found = false;
+
+	ASSERT (pg_ofs (start) == 0);
+
+	rwlock_acquire_read (&spt->lock);
+	for (size_t i = run_search (spt, lo);
+			!found && i < spt->run_cnt && spt->runs[i].start < hi; i++) {
+		const struct spt_run *r = &spt->runs[i];
+		uintptr_t end = r->end < hi ? r->end : hi;
+
+		for (uintptr_t va = r->start > lo ? r->start : lo; va < end; va += PGSIZE)
+			if (spt_lookup (spt, va) != NULL) {
+				found = true;
+				break;
+			}
+	}
+	rwlock_release_read (&spt->lock);
+
+	return found;
+}
+
+/* START부터 PAGE_CNT 페이지 안에 매핑된 페이지를 모두 spt에서 빼고 해제.
+ * 해제한 페이지 수를 반환. munmap에서 씀. 페이지를 해제하는 동안 락을
+ * 잡고 있으므로 페이지의 destroy는 spt를 건드리면 안 됨 */
+size_t
+spt_remove_range (struct supplemental_page_table *spt, void *start,
+		size_t page_cnt) {
+	uintptr_t lo = (uintptr_t) start;
+	uintptr_t hi = lo + page_cnt * PGSIZE;
+	size_t removed = 0;
+
+	ASSERT (pg_ofs (start) == 0);
+
+	rwlock_acquire_write (&spt->lock);
+	for (size_t i = run_search (spt, lo);
+			i < spt->run_cnt && spt->runs[i].start < hi; i++) {
+		const struct spt_run *r = &spt->runs[i];
+		uintptr_t end = r->end < hi ? r->end : hi;
+
+		for (uintptr_t va = r->start > lo ? r->start : lo; va < end; va += PGSIZE) {
+			struct page *page = spt_lookup (spt, va);
+
+			if (page != NULL) {
+				hash_delete (&spt->pages, &page->spt_elem);
+				vm_dealloc_page (page);
+				removed++;
+			}
+		}
+	}
+	run_cut (spt, lo, hi);
+	rwlock_release_write (&spt->lock);
+
+	return removed;
+}
+
+/* 락을 잡은 채로 호출. 페이지 시작 주소 VA의 페이지를 찾아 반환 */
+static struct page *
+spt_lookup (struct supplemental_page_table *spt, uintptr_t va) {
+	struct page key;
+	struct hash_elem *e;
+
+	key.va = (void *) va;
+	e = hash_find (&spt->pages, &key.spt_elem);
+	return e != NULL ? hash_entry (e, struct page, spt_elem) : NULL;
+}
+
+static uint64_t
+page_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct page *p = hash_entry (e, struct page, spt_elem);
+
+	return hash_bytes (&p->va, sizeof p->va);
+}
+
+static bool
+page_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct page, spt_elem)->va
+		< hash_entry (b, struct page, spt_elem)->va;
+}
+
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED) {
+	vm_dealloc_page (hash_entry (e, struct page, spt_elem));
+}
+
+/* 끝 주소가 VA보다 큰 첫 구간의 인덱스. 없다면 run_cnt */
+static size_t
+run_search (const struct supplemental_page_table *spt, uintptr_t va) {
+	size_t lo = 0, hi = spt->run_cnt;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (spt->runs[mid].end <= va)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* 구간 배열에 CNT개가 들어갈 자리를 마련. 메모리가 부족하면 false */
+static bool
+run_reserve (struct supplemental_page_table *spt, size_t cnt) {
+	size_t cap = spt->run_cap > 0 ? spt->run_cap : 8;
+	struct spt_run *runs;
+
+	if (cnt <= spt->run_cap)
+		return true;
+	while (cap < cnt)
+		cap *= 2;
+	runs = realloc (spt->runs, cap * sizeof *runs);
+	if (runs == NULL)
+		return false;
+	spt->runs = runs;
+	spt->run_cap = cap;
 	return true;
 }
 
+/* 페이지 VA를 구간에 더함. 앞뒤 구간과 이어지면 합침. 메모리가 부족하면
+ * false */
+static bool
+run_add (struct supplemental_page_table *spt, uintptr_t va) {
+	size_t i = run_search (spt, va);
+	struct spt_run *runs = spt->runs;
+	bool left, right;
+
+	/* 구간을 나누지 못해 이미 덮고 있는 자리 */
+	if (i < spt->run_cnt && runs[i].start <= va)
+		return true;
+
+	left = i > 0 && runs[i - 1].end == va;
+	right = i < spt->run_cnt && runs[i].start == va + PGSIZE;
+	if (left && right) {
+		runs[i - 1].end = runs[i].end;
+		memmove (&runs[i], &runs[i + 1], (spt->run_cnt - i - 1) * sizeof *runs);
+		spt->run_cnt--;
+	} else if (left)
+		runs[i - 1].end += PGSIZE;
+	else if (right)
+		runs[i].start = va;
+	else {
+		if (!run_reserve (spt, spt->run_cnt + 1))
+			return false;
+		runs = spt->runs;
+		memmove (&runs[i + 1], &runs[i], (spt->run_cnt - i) * sizeof *runs);
+		runs[i].start = va;
+		runs[i].end = va + PGSIZE;
+		spt->run_cnt++;
+	}
+	return true;
+}
+
+/* 구간들에서 [LO, HI)를 잘라냄. 구간을 둘로 나눌 메모리가 없다면 그
+ * 구간은 그대로 둠 */
+static void
+run_cut (struct supplemental_page_table *spt, uintptr_t lo, uintptr_t hi) {
+	size_t first = run_search (spt, lo);
+	size_t last = first;
+	struct spt_run head, tail;
+	size_t keep = 0;
+
+	if (lo >= hi)
+		return;
+	while (last < spt->run_cnt && spt->runs[last].start < hi)
+		last++;
+	if (first == last)
+		return;
+
+	/* 잘라낸 범위 앞뒤로 삐져나온 부분만 남김 */
+	head.start = spt->runs[first].start;
+	head.end = lo;
+	tail.start = hi;
+	tail.end = spt->runs[last - 1].end;
+	keep = (head.start < head.end) + (tail.start < tail.end);
+	if (keep > last - first && !run_reserve (spt, spt->run_cnt + 1))
+		return;
+
+	memmove (&spt->runs[first + keep], &spt->runs[last],
+			(spt->run_cnt - last) * sizeof *spt->runs);
+	spt->run_cnt = spt->run_cnt - (last - first) + keep;
+	if (head.start < head.end)
+		spt->runs[first++] = head;
+	if (tail.start < tail.end)
+		spt->runs[first] = tail;
+}
+
 /* Get the struct frame, that will be evicted. */
 static struct frame *
 vm_get_victim (void) {
@@ -132,7 +358,7 @@ vm_handle_wp (struct page *page UNUSED) {
 bool
 vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
-	struct supplemental_page_table *spt UNUSED = &thread_current ()->spt;
+	struct supplemental_page_table *spt UNUSED = &thread_current ()->proc->spt;
 	struct page *page = NULL;
 	/* TODO: Validate the fault */
 	/* TODO: Your code goes here */
@@ -172,8 +398,14 @@ vm_do_claim_page (struct page *page) {
 }
 
 /* Initialize new supplemental page table */
-void
-supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
+/* 해시 테이블의 버킷을 할당하지 못하면 false */
+bool
+supplemental_page_table_init (struct supplemental_page_table *spt) {
+	rwlock_init (&spt->lock);
+	spt->runs = NULL;
+	spt->run_cnt = 0;
+	spt->run_cap = 0;
+	return hash_init (&spt->pages, page_hash, page_less, NULL);
 }
 
 /* Copy supplemental page table from src to dst */
@@ -184,7 +416,23 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 
 /* Free the resource hold by the supplemental page table */
 void
-supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
+supplemental_page_table_kill (struct supplemental_page_table *spt) {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
+	/* exec는 같은 spt에 새 프로그램을 올리므로 비우기만 함 */
+	rwlock_acquire_write (&spt->lock);
+	hash_clear (&spt->pages, page_destroy);
+	free (spt->runs);
+	spt->runs = NULL;
+	spt->run_cnt = 0;
+	spt->run_cap = 0;
+	rwlock_release_write (&spt->lock);
+}
+
+/* 프로세스를 해제할 때 supplemental_page_table_kill() 뒤에 호출.
+ * 해시 테이블의 버킷까지 해제함 */
+void
+supplemental_page_table_destroy (struct supplemental_page_table *spt) {
+	ASSERT (hash_empty (&spt->pages));
+	hash_destroy (&spt->pages, NULL);
 }